@@ -0,0 +1,202 @@
+#include <chrono>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <iostream>
+#include <tuple>
+#include <algorithm>
+#include <functional>
+
+#include <compiler/compiler.h>
+#include "program_generator.h"
+
+// Compiles generated programs of growing size and reports the throughput of
+// lexing, parsing and the whole compile. Every result is also written as one
+// JSON object per line, so that runs can be compared and the time per
+// statement plotted against the size to spot non-linear scaling. With
+// --arena 1 the compiles use CompileOptions::useArena, and the results add the
+// allocations taken from the arena by the lexer and the parser, and for the
+// whole compile the blocks the arena took from the heap.
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    struct Settings
+    {
+        std::vector<ProgramShape> shapes{ ProgramShape::Mixed, ProgramShape::ExpressionChains, ProgramShape::NestedIndexing, ProgramShape::ManyDimensions };
+        std::vector<size_t> sizes{ 1000, 10000, 100000 };
+        uint64_t seed{ 1 };
+        size_t warmup{ 1 };
+        size_t repetitions{ 5 };
+        bool arena{ false };
+        std::string output;
+    };
+
+    struct Sample
+    {
+        double lex{ 0 };
+        double parse{ 0 };
+        double total{ 0 };
+        ArenaStatistics allocations;
+    };
+
+    double Seconds(std::chrono::nanoseconds duration)
+    {
+        return std::chrono::duration<double>(duration).count();
+    }
+
+    template<typename T>
+    std::vector<T> ParseList(const std::string& text, const std::function<T(const std::string&)>& parse)
+    {
+        std::vector<T> values;
+        std::istringstream stream(text);
+        for (std::string item; std::getline(stream, item, ',');)
+            values.push_back(parse(item));
+        return values;
+    }
+
+    Settings ParseArguments(int argc, char* argv[])
+    {
+        Settings settings;
+        for (int i = 1; i < argc; i++)
+        {
+            const std::string option = argv[i];
+            if (i + 1 == argc)
+                throw std::runtime_error("Missing value of " + option);
+
+            const std::string value = argv[++i];
+            if (option == "--shapes")
+            {
+                settings.shapes = ParseList<ProgramShape>(value, [](const std::string& name)
+                {
+                    const auto shape = ParseShape(name);
+                    if (!shape)
+                        throw std::runtime_error("Unknown shape '" + name + "'");
+                    return *shape;
+                });
+            }
+            else if (option == "--sizes")
+                settings.sizes = ParseList<size_t>(value, [](const std::string& size) { return static_cast<size_t>(std::stod(size)); });
+            else if (option == "--seed")
+                settings.seed = std::stoull(value);
+            else if (option == "--warmup")
+                settings.warmup = std::stoul(value);
+            else if (option == "--repetitions")
+                settings.repetitions = std::max<size_t>(std::stoul(value), 1);
+            else if (option == "--arena")
+                settings.arena = value != "0";
+            else if (option == "--output")
+                settings.output = value;
+            else
+                throw std::runtime_error("Unknown option " + option);
+        }
+        return settings;
+    }
+
+    Sample Measure(const Compiler& compiler, const std::string& program, bool arena)
+    {
+        CompileOptions options;
+        options.collectStatistics = true;
+        options.useArena = arena;
+
+        CompileReport report;
+        std::string input = program;
+
+        const auto start = Clock::now();
+        compiler.Compile(std::move(input), options, &report);
+        const auto total = Clock::now() - start;
+
+        return Sample{ Seconds(report.statistics.tokenize), Seconds(report.statistics.parse), Seconds(total), report.arena };
+    }
+
+    double Median(std::vector<double> values)
+    {
+        std::sort(values.begin(), values.end());
+        const size_t middle = values.size() / 2;
+        return values.size() % 2 ? values[middle] : (values[middle - 1] + values[middle]) / 2;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    try
+    {
+        const Settings settings = ParseArguments(argc, argv);
+
+        std::ofstream file;
+        if (!settings.output.empty())
+        {
+            file.open(settings.output, std::ios::trunc);
+            if (!file)
+                throw std::runtime_error("Cannot write '" + settings.output + "'");
+        }
+        std::ostream& results = settings.output.empty() ? std::cout : file;
+
+        const Compiler compiler;
+        std::cerr << std::left << std::setw(12) << "shape" << std::setw(10) << "phase" << std::right
+            << std::setw(12) << "statements" << std::setw(12) << "MB/s" << std::setw(14) << "statements/s" << std::setw(14) << "ns/statement" << '\n';
+
+        for (const size_t size : settings.sizes)
+        {
+            for (const ProgramShape shape : settings.shapes)
+            {
+                const std::string program = GenerateProgram(shape, size, settings.seed);
+                const size_t statements = static_cast<size_t>(std::count(program.begin(), program.end(), ';'));
+
+                for (size_t i = 0; i < settings.warmup; i++)
+                    Measure(compiler, program, settings.arena);
+
+                std::vector<Sample> samples;
+                for (size_t i = 0; i < settings.repetitions; i++)
+                    samples.push_back(Measure(compiler, program, settings.arena));
+
+                // Allocation counts do not vary between runs of the same program.
+                const ArenaStatistics& allocations = samples.front().allocations;
+                const std::tuple<const char*, double Sample::*, AllocationCounters> phases[] = {
+                    { "lex", &Sample::lex, allocations.tokenize },
+                    { "parse", &Sample::parse, allocations.parse },
+                    { "compile", &Sample::total, allocations.heap },
+                };
+
+                for (const auto& [phase, member, counters] : phases)
+                {
+                    std::vector<double> times;
+                    for (const Sample& sample : samples)
+                        times.push_back(sample.*member);
+
+                    const double median = Median(times);
+                    const double best = *std::min_element(times.begin(), times.end());
+                    const double megabytes = program.size() / 1e6 / median;
+                    const double perSecond = statements / median;
+                    const double nsPerStatement = median * 1e9 / statements;
+
+                    results << std::setprecision(9)
+                        << "{\"shape\":\"" << ShapeName(shape) << "\",\"phase\":\"" << phase
+                        << "\",\"statements\":" << statements << ",\"bytes\":" << program.size()
+                        << ",\"seed\":" << settings.seed << ",\"repetitions\":" << settings.repetitions
+                        << ",\"median_s\":" << median << ",\"min_s\":" << best
+                        << ",\"mb_per_s\":" << megabytes << ",\"statements_per_s\":" << perSecond
+                        << ",\"ns_per_statement\":" << nsPerStatement;
+                    if (settings.arena)
+                        results << ",\"arena\":true,\"allocations\":" << counters.count << ",\"allocated_bytes\":" << counters.bytes;
+                    results << "}\n";
+
+                    std::cerr << std::fixed << std::setprecision(1) << std::left << std::setw(12) << ShapeName(shape) << std::setw(10) << phase << std::right
+                        << std::setw(12) << statements << std::setw(12) << megabytes << std::setw(14) << std::setprecision(0) << perSecond
+                        << std::setw(14) << std::setprecision(1) << nsPerStatement << '\n';
+                    std::cerr.unsetf(std::ios::fixed);
+                }
+            }
+        }
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,250 @@
+#include <array>
+#include <random>
+
+#include "program_generator.h"
+
+namespace
+{
+    constexpr std::array<std::string_view, 4> ShapeNames = { "mixed", "chains", "nested", "dimensions" };
+    constexpr std::array<char, 4> Operators = { '+', '-', '*', '/' };
+
+    constexpr size_t Scalars = 16;
+    constexpr size_t Arrays = 4;
+    constexpr size_t ChainLength = 64;
+    constexpr size_t NestingDepth = 32;
+    constexpr size_t Dimensions = 12;
+
+    class Generator
+    {
+    public:
+        explicit Generator(uint64_t seed)
+            : m_random(seed)
+        {
+        }
+
+        size_t Below(size_t limit)
+        {
+            return std::uniform_int_distribution<size_t>(0, limit - 1)(m_random);
+        }
+
+        void Scalar()
+        {
+            m_text += 'v';
+            m_text += std::to_string(Below(Scalars));
+        }
+
+        void Operand()
+        {
+            switch (Below(6))
+            {
+            case 0:
+                m_text += std::to_string(Below(1000));
+                break;
+            case 1:
+                m_text += "m" + std::to_string(Below(Arrays)) + "[";
+                Scalar();
+                m_text += "][" + std::to_string(Below(8)) + "]";
+                break;
+            default:
+                Scalar();
+                break;
+            }
+        }
+
+        // An expression of the given number of operands with an occasional
+        // negation or parenthesized part.
+        void Expression(size_t operands)
+        {
+            for (size_t i = 0; i < operands; i++)
+            {
+                if (i > 0)
+                {
+                    m_text += ' ';
+                    m_text += Operators[Below(Operators.size())];
+                    m_text += ' ';
+                }
+
+                const size_t form = Below(16);
+                if (form == 0 && operands - i > 2)
+                {
+                    m_text += '(';
+                    Expression(2);
+                    m_text += ')';
+                }
+                else if (form == 1)
+                {
+                    m_text += '-';
+                    Operand();
+                }
+                else
+                {
+                    Operand();
+                }
+            }
+        }
+
+        void Declarations()
+        {
+            for (size_t i = 0; i < Scalars; i++)
+                m_text += "int v" + std::to_string(i) + " = " + std::to_string(i) + "; ";
+            for (size_t i = 0; i < Arrays; i++)
+                m_text += "int[8][8] m" + std::to_string(i) + "; ";
+            m_text += "float[64] f; ";
+        }
+
+        void Mixed(size_t statements)
+        {
+            Declarations();
+            for (size_t s = Scalars + Arrays + 1; s < statements; s++)
+            {
+                const size_t kind = Below(10);
+                if (kind == 0)
+                {
+                    m_text += "int w" + std::to_string(s) + " = ";
+                }
+                else if (kind < 4)
+                {
+                    m_text += "m" + std::to_string(Below(Arrays)) + "[";
+                    Scalar();
+                    m_text += "][" + std::to_string(Below(8)) + "] = ";
+                }
+                else if (kind == 4)
+                {
+                    m_text += "f[";
+                    Scalar();
+                    m_text += "] = ";
+                }
+                else
+                {
+                    Scalar();
+                    m_text += " = ";
+                }
+
+                Expression(1 + Below(6));
+                m_text += "; ";
+            }
+        }
+
+        void ExpressionChains(size_t statements)
+        {
+            Declarations();
+            for (size_t s = Scalars + Arrays + 1; s < statements; s++)
+            {
+                Scalar();
+                m_text += " = ";
+                for (size_t i = 0; i < ChainLength; i++)
+                {
+                    if (i > 0)
+                    {
+                        m_text += ' ';
+                        m_text += Operators[Below(Operators.size())];
+                        m_text += ' ';
+                    }
+                    Scalar();
+                }
+                m_text += "; ";
+            }
+        }
+
+        void NestedIndexing(size_t statements)
+        {
+            Declarations();
+            for (size_t i = 0; i < Arrays; i++)
+                m_text += "int[16] a" + std::to_string(i) + "; ";
+
+            for (size_t s = Scalars + 2 * Arrays + 1; s < statements; s++)
+            {
+                for (size_t i = 0; i < NestingDepth; i++)
+                    m_text += "a" + std::to_string(Below(Arrays)) + "[";
+                Scalar();
+                m_text += std::string(NestingDepth, ']') + " = ";
+                Expression(2);
+                m_text += "; ";
+            }
+        }
+
+        void ManyDimensions(size_t statements)
+        {
+            Declarations();
+            size_t declared = 0;
+            for (size_t s = Scalars + Arrays + 1; s < statements; s++)
+            {
+                // Every fourth statement declares a new array.
+                if (declared == 0 || Below(4) == 0)
+                {
+                    m_text += "int";
+                    for (size_t d = 0; d < Dimensions; d++)
+                        m_text += "[" + std::to_string(2 + Below(2)) + "]";
+                    m_text += " d" + std::to_string(declared++) + "; ";
+                    continue;
+                }
+
+                const auto access = [this, declared]
+                {
+                    m_text += "d" + std::to_string(Below(declared));
+                    for (size_t d = 0; d < Dimensions; d++)
+                    {
+                        m_text += '[';
+                        if (Below(3) == 0)
+                            Scalar();
+                        else
+                            m_text += std::to_string(Below(2));
+                        m_text += ']';
+                    }
+                };
+
+                access();
+                m_text += " = ";
+                access();
+                m_text += " + ";
+                Scalar();
+                m_text += "; ";
+            }
+        }
+
+        std::string Take()
+        {
+            return std::move(m_text);
+        }
+
+    private:
+        std::mt19937_64 m_random;
+        std::string m_text;
+    };
+}
+
+std::string_view ShapeName(ProgramShape shape)
+{
+    return ShapeNames[static_cast<size_t>(shape)];
+}
+
+std::optional<ProgramShape> ParseShape(std::string_view name)
+{
+    for (size_t i = 0; i < ShapeNames.size(); i++)
+    {
+        if (ShapeNames[i] == name)
+            return static_cast<ProgramShape>(i);
+    }
+    return std::nullopt;
+}
+
+std::string GenerateProgram(ProgramShape shape, size_t statements, uint64_t seed)
+{
+    Generator generator(seed);
+    switch (shape)
+    {
+    case ProgramShape::Mixed:
+        generator.Mixed(statements);
+        break;
+    case ProgramShape::ExpressionChains:
+        generator.ExpressionChains(statements);
+        break;
+    case ProgramShape::NestedIndexing:
+        generator.NestedIndexing(statements);
+        break;
+    case ProgramShape::ManyDimensions:
+        generator.ManyDimensions(statements);
+        break;
+    }
+    return generator.Take();
+}
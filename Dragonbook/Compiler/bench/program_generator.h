@@ -0,0 +1,29 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+// Kinds of programs the benchmark compiles. Mixed is meant to look like real
+// code; the others stress one part of the compiler each.
+enum class ProgramShape
+{
+    // Declarations, scalar and array assignments with short expressions.
+    Mixed,
+    // Assignments of long + - * / chains. All operators are right-associative,
+    // so every chain grows the parse stack by its length.
+    ExpressionChains,
+    // Stores to a[b[c[...]]] indexed through deeply nested arrays.
+    NestedIndexing,
+    // Declarations of arrays with many dimensions and accesses to them.
+    ManyDimensions,
+};
+
+std::string_view ShapeName(ProgramShape shape);
+std::optional<ProgramShape> ParseShape(std::string_view name);
+
+// A valid program of about the given number of statements, separated by
+// spaces as the tokenizer takes no newlines. It starts with the declarations
+// the statements use. The same shape, size and seed always give the same text.
+std::string GenerateProgram(ProgramShape shape, size_t statements, uint64_t seed);
@@ -1,6 +1,182 @@
 #pragma once
 
+#include <span>
+#include <chrono>
+#include <memory>
+#include <istream>
+#include <ostream>
 #include <string>
+#include <vector>
+#include <utility>
+#include <exception>
 #include <filesystem>
 
+#include <compiler/ir.h>
+#include <compiler/memory_layout.h>
+
+struct CompileOptions
+{
+    // Fold arithmetic on constants and collapse constant array offsets into
+    // a single literal while generating code.
+    bool foldConstants{ false };
+
+    // Run local value numbering over the generated code, see
+    // EliminateCommonSubexpressions.
+    bool eliminateCommonSubexpressions{ false };
+
+    // Propagate copies and remove dead code afterwards, see PropagateCopies
+    // and EliminateDeadCode.
+    bool propagateCopies{ false };
+
+    // Map the temporaries onto this many virtual registers plus spill slots
+    // after all other passes, see AllocateRegisters. 0 keeps every
+    // temporary apart.
+    size_t registers{ 0 };
+
+    // Split the program at statement boundaries into up to this many chunks
+    // and parse them in parallel, on no more threads than the hardware has.
+    // The code is the same as when parsing the program as a whole, which 0
+    // and 1 do.
+    size_t parallelChunks{ 0 };
+
+    // Tokenize on a separate thread while parsing, see TokenPipeline. Errors
+    // are the same as without it. Ignored when parsing in chunks.
+    bool pipelineLexer{ false };
+
+    // Lay out the storage of the final code, see AllocateStorage. The layout
+    // goes to CompileReport::storage.
+    bool allocateStorage{ false };
+
+    // Time the phases of the compile and count the work of the parser into
+    // CompileReport::statistics. Without it the parser is instantiated
+    // without any counters. Only the sequential parse is counted; with
+    // parallelChunks or pipelineLexer the parser figures stay zero.
+    bool collectStatistics{ false };
+
+    // Allocate the token queue, the parse stack and the code being built
+    // from a monotonic arena released at once at the end of the compile, and
+    // count the allocations into CompileReport::arena. Ignored with
+    // parallelChunks or pipelineLexer.
+    bool useArena{ false };
+};
+
+struct AllocationCounters
+{
+    size_t count{ 0 };
+    size_t bytes{ 0 };
+};
+
+// Allocations of a compile with CompileOptions::useArena.
+struct ArenaStatistics
+{
+    // Allocations served by the arena while tokenizing and parsing.
+    AllocationCounters tokenize;
+    AllocationCounters parse;
+    // Blocks the arena took from the default memory resource. Block sizes
+    // grow geometrically, so this stays logarithmic in the size of the
+    // program. The tokenizer and the parser take nothing else from the heap
+    // per statement; only the tables of the resulting code grow there, also
+    // geometrically.
+    AllocationCounters heap;
+};
+
+// Where the time of one compilation went, see CompileOptions::collectStatistics.
+struct CompileStatistics
+{
+    // Wall time of every phase. The grammar is loaded once per Compiler, and
+    // grammarLoad is that time for every compile made with it; print is only
+    // measured by Compile.
+    std::chrono::nanoseconds grammarLoad{ 0 };
+    std::chrono::nanoseconds tokenize{ 0 };
+    std::chrono::nanoseconds parse{ 0 };
+    std::chrono::nanoseconds passes{ 0 };
+    std::chrono::nanoseconds print{ 0 };
+
+    size_t tokens{ 0 };
+    size_t shifts{ 0 };
+    // Every production of the grammar with the number of reductions by it.
+    std::vector<std::pair<std::string, size_t>> reductions;
+    // Largest number of states on the parse stack.
+    size_t stackHighWater{ 0 };
+    // Temporaries created by the parser, before any pass removes some.
+    size_t temps{ 0 };
+    size_t quads{ 0 };
+    // Size of the text Compile returns.
+    size_t codeBytes{ 0 };
+};
+
+// What the optional passes did to the code of one compilation.
+struct CompileReport
+{
+    size_t eliminatedSubexpressions{ 0 };
+    size_t coalescedCopies{ 0 };
+    size_t removedDeadCode{ 0 };
+    size_t registersUsed{ 0 };
+    size_t spillSlots{ 0 };
+    // Filled in with CompileOptions::allocateStorage; PrintStorageLayout
+    // renders it as a map.
+    StorageLayout storage;
+    CompileStatistics statistics;
+    ArenaStatistics arena;
+};
+
+// Outcome of compiling one input of a batch.
+struct CompileResult
+{
+    std::string code;
+    // Set instead of code when compiling the input threw.
+    std::exception_ptr error;
+
+    bool Succeeded() const
+    {
+        return !error;
+    }
+};
+
+// Owns a loaded grammar and compiles programs with it. The grammar tables are
+// immutable and shared by copies of the Compiler; Compile keeps all of its
+// state (symbol table, temporaries) per call, so one instance can be used
+// from many threads at once.
+class Compiler
+{
+public:
+    // Uses the grammar.csv tables built into the library.
+    Compiler();
+
+    // Loads grammar tables from a CSV file.
+    explicit Compiler(const std::filesystem::path& grammar);
+
+    // If report is not null, it receives the statistics of the passes
+    // enabled by options.
+    std::string Compile(std::string&& input, const CompileOptions& options = {}, CompileReport* report = nullptr) const;
+
+    // Same as Compile, but returns the code as quads instead of text.
+    ThreeAddressCode CompileToIr(std::string&& input, const CompileOptions& options = {}, CompileReport* report = nullptr) const;
+
+    // Compiles a program read from input in chunks of chunkSize bytes,
+    // writing the code of every top-level statement to output as soon as it
+    // is parsed. Only the current statement is kept in memory, apart from the
+    // symbol table; a run of declarations counts as one statement, as
+    // Declarations is right-recursive. The text written is the same as
+    // Compile returns, but the passes over the whole program are not run.
+    // After an error, output holds the code of the statements before it.
+    void CompileStream(std::istream& input, std::ostream& output, const CompileOptions& options = {}, size_t chunkSize = 64 * 1024) const;
+
+    // Compiles independent inputs on a work-stealing pool of the given number
+    // of threads (0 for one per hardware thread), all sharing this grammar.
+    // Results are in the order of the inputs; an input that fails to compile
+    // does not affect the others.
+    std::vector<CompileResult> CompileBatch(std::span<const std::string> inputs, const CompileOptions& options = {}, size_t threads = 0) const;
+
+private:
+    friend class IncrementalCompiler;
+
+    struct Grammar;
+    std::shared_ptr<const Grammar> m_grammar;
+};
+
+// Compiles input using the grammar tables from a CSV file.
 std::string Compile(const std::filesystem::path& grammar, std::string&& input);
+
+// Compiles input using the grammar.csv tables built into the library.
+std::string Compile(std::string&& input);
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include <compiler/compiler.h>
+
+// Compiles successive versions of one program, such as the text of an editor
+// buffer, redoing only the work that an edit affects.
+//
+// The program is kept as a list of units: runs of declarations ended by an
+// assignment, each of which parses on its own. For every unit the compiler
+// remembers its place in the text, its code with temporaries numbered from
+// zero, the symbols it declares and the names it refers to. A new version is
+// compared with the previous one; units outside of the changed text are kept,
+// the changed text is tokenized and parsed again, and so is every later unit
+// that refers to a name whose declarations were added or removed. The code is
+// then stitched together as by the parallel parse, so it is the same as what
+// Compiler::Compile gives for the whole text. Temporaries of the units before
+// the edit keep their numbers.
+class IncrementalCompiler
+{
+public:
+    // Work done by the latest compile.
+    struct Statistics
+    {
+        size_t reusedUnits{ 0 };
+        size_t compiledUnits{ 0 };
+    };
+
+    explicit IncrementalCompiler(Compiler compiler = {}, CompileOptions options = {});
+    ~IncrementalCompiler();
+
+    IncrementalCompiler(IncrementalCompiler&&) noexcept;
+    IncrementalCompiler& operator=(IncrementalCompiler&&) noexcept;
+
+    std::string Compile(const std::string& input, CompileReport* report = nullptr);
+    ThreeAddressCode CompileToIr(const std::string& input, CompileReport* report = nullptr);
+
+    const Statistics& LastCompile() const;
+
+private:
+    struct Unit;
+    struct Units;
+
+    Compiler m_compiler;
+    CompileOptions m_options;
+    std::unique_ptr<Units> m_units;
+    Statistics m_statistics;
+};
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cstddef>
+
+#include <compiler/ir.h>
+
+// Result of running a program: the final memory image together with what is
+// needed to find the variables in it.
+struct ExecutionResult
+{
+    // Variables laid out by LayOutVariables, variable i starts at offsets[i].
+    std::vector<std::byte> memory;
+    std::vector<size_t> offsets;
+    std::vector<IrVariable> variables;
+
+    // Quads executed and the time it took, without decoding.
+    uint64_t instructions{ 0 };
+    std::chrono::nanoseconds elapsed{ 0 };
+
+    double InstructionsPerSecond() const;
+
+    // Value of a variable, or of the array element at a byte offset into it.
+    int64_t Value(const std::string& name, size_t offset = 0) const;
+};
+
+// Runs the code. All arithmetic is done on 64-bit integers, as the code is
+// generated for ints; float elements are converted when they are loaded and
+// stored. The quads are decoded once into an instruction array with operands
+// resolved to pointers and executed by a direct-threaded loop (computed goto
+// on GCC and Clang, a switch elsewhere). Throws std::runtime_error on a
+// division by zero or an access outside of the memory image.
+ExecutionResult Execute(const ThreeAddressCode& code);
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <optional>
+
+// Three-address code produced by the compiler, kept as a flat array of quads.
+// Operands refer to variables, temporaries and constants by index into the
+// tables of ThreeAddressCode, so passes over the code never deal with names.
+
+enum class OpCode : uint8_t
+{
+    Add,     // result = arg1 + arg2
+    Sub,     // result = arg1 - arg2
+    Mul,     // result = arg1 * arg2
+    Div,     // result = arg1 / arg2
+    Copy,    // result = arg1
+    Load,    // result = arg1[arg2], arg1 is an array, arg2 a byte offset
+    Address, // result = arg1 + arg2, address of the element of array arg1 at byte offset arg2
+    Store    // *result = arg1, result holds an address computed by Address
+};
+
+struct Operand
+{
+    enum class Kind : uint8_t
+    {
+        None,
+        Variable,
+        Temp,
+        Constant
+    };
+
+    Kind kind{ Kind::None };
+    uint32_t id{ 0 };
+
+    bool operator ==(const Operand& rhs) const = default;
+};
+
+struct Quad
+{
+    OpCode op{ OpCode::Copy };
+    Operand result;
+    Operand arg1;
+    Operand arg2;
+
+    bool operator ==(const Quad& rhs) const = default;
+};
+
+struct IrVariable
+{
+    std::string name;
+    // Type as declared ("int", "float[][]"), empty for variables that are
+    // only assigned and never declared.
+    std::string type;
+    // Size of the whole variable in bytes, 0 for undeclared variables.
+    size_t size{ 0 };
+};
+
+// Type of the values a temporary holds; Size is a byte offset into an array.
+enum class ScalarType : uint8_t
+{
+    Int,
+    Float,
+    Size
+};
+
+struct IrTemp
+{
+    ScalarType type{ ScalarType::Int };
+    size_t size{ 0 };
+};
+
+struct IrConstant
+{
+    // Literal as written; this is what is printed.
+    std::string text;
+    // Value of the literal, empty if it does not fit in 64 bits.
+    std::optional<int64_t> value;
+};
+
+// Value of a constant for the passes that evaluate it. Throws
+// std::runtime_error if the literal does not fit in 64 bits.
+int64_t ConstantValue(const IrConstant& constant);
+
+struct ThreeAddressCode
+{
+    std::vector<Quad> quads;
+    std::vector<IrVariable> variables;
+    std::vector<IrTemp> temps;
+    std::vector<IrConstant> constants;
+};
+
+// Temporaries are printed as tN, where N is their index.
+std::string OperandName(const ThreeAddressCode& code, const Operand& operand);
+
+// Prints the code in the textual format returned by Compile.
+std::string PrintThreeAddressCode(const ThreeAddressCode& code);
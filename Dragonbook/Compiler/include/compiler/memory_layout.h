@@ -0,0 +1,54 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <compiler/ir.h>
+
+// Where the variables of a program live in its flat memory image. Both the
+// interpreter and the native backend lay memory out this way, so their final
+// memory images can be compared byte for byte.
+struct MemoryLayout
+{
+    // Variable i starts at offsets[i].
+    std::vector<size_t> offsets;
+    size_t size{ 0 };
+};
+
+bool IsArray(const IrVariable& variable);
+bool IsFloat(const IrVariable& variable);
+
+// Size of a scalar or of one array element. Undeclared variables are ints.
+size_t ElementSize(const IrVariable& variable);
+
+// Size of the whole variable in memory.
+size_t StorageSize(const IrVariable& variable);
+
+// Storage of a whole program: the variables in a data segment, which is the
+// memory image, and the temporaries in slots of the stack frame.
+struct StorageLayout
+{
+    MemoryLayout data;
+    // Temporary i starts at frame.offsets[i].
+    MemoryLayout frame;
+
+    size_t Footprint() const
+    {
+        return data.size + frame.size;
+    }
+};
+
+// Assigns every variable and temporary of the code an aligned offset. Items
+// are placed by decreasing alignment, so padding is only needed where the
+// scalars end and the arrays begin. Scalars come first, the most used ones
+// at the start of the segment, so that hot scalars share a cache line;
+// arrays follow from the smallest up. Every temporary holds a 64-bit value
+// and takes an 8-byte slot, the most used ones first.
+StorageLayout AllocateStorage(const ThreeAddressCode& code);
+
+// The data segment of AllocateStorage.
+MemoryLayout LayOutVariables(const ThreeAddressCode& code);
+
+// One line per item in address order, "name: segment+offset, size bytes",
+// followed by the footprint.
+std::string PrintStorageLayout(const ThreeAddressCode& code, const StorageLayout& layout);
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <compiler/ir.h>
+
+// Passes over the three-address code. Each one rewrites the code in place and
+// returns the number of instructions it removed.
+
+// Local value numbering (Dragon Book 8.5): a repeated computation of a value
+// that is still available is replaced by the temporary computed first. A
+// store to a variable gives it a new value number, a store through *t
+// invalidates the loads from the array t points into.
+size_t EliminateCommonSubexpressions(ThreeAddressCode& code);
+
+// Copy propagation over the SSA form of the code. The code is a single basic
+// block, so SSA form amounts to numbering the definitions of every variable;
+// the pass tracks those versions instead of renaming the variables. First a
+// temporary that is only copied into a variable is computed straight into it
+// (t = a + b; x = t becomes x = a + b). Then uses of a copied variable are
+// replaced by the source of the copy while that version of the source is
+// still current. The copies themselves are left for EliminateDeadCode.
+size_t PropagateCopies(ThreeAddressCode& code);
+
+// Removes computations of temporaries that are never used and stores to
+// variables that are overwritten before being read. The final value of every
+// variable and all stores through *t are live. Temporaries left unused are
+// dropped from code.temps and the rest are renumbered in order.
+size_t EliminateDeadCode(ThreeAddressCode& code);
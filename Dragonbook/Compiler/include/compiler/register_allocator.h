@@ -0,0 +1,54 @@
+#pragma once
+
+#include <vector>
+
+#include <compiler/ir.h>
+
+// Every temporary is assigned once and then read by the quads that follow, so
+// its live range is the interval from the defining quad to the last use.
+struct LiveInterval
+{
+    uint32_t temp{ 0 };
+    size_t start{ 0 };
+    size_t end{ 0 };
+};
+
+// Live intervals of the temporaries in the order of their definitions.
+// Temporaries that are never defined have no interval.
+std::vector<LiveInterval> ComputeLiveIntervals(const ThreeAddressCode& code);
+
+struct TempLocation
+{
+    enum class Kind : uint8_t
+    {
+        None,
+        Register,
+        Spill
+    };
+
+    Kind kind{ Kind::None };
+    uint32_t index{ 0 };
+};
+
+struct RegisterAllocation
+{
+    // Location of every temporary, indexed by its id.
+    std::vector<TempLocation> temps;
+    // Number of registers in use, at most the number available.
+    size_t registers{ 0 };
+    // Number of stack slots holding the temporaries that did not fit.
+    size_t spillSlots{ 0 };
+};
+
+// Linear scan allocation (Poletto and Sarkar) of the temporaries onto the
+// given number of virtual registers. When all of them are taken, the interval
+// that ends last is spilled. Spill slots are reused once the interval in them
+// ends; an interval evicted from its register takes only a slot that has been
+// free since the interval started.
+RegisterAllocation AllocateRegisters(const ThreeAddressCode& code, size_t registers);
+
+// Renames the temporaries to their locations: registers become t0 .. tR-1
+// and spill slots follow them. code.temps is replaced by one entry per
+// location, as wide as the widest temporary it holds. Temporaries are no
+// longer assigned only once afterwards, so this has to be the last pass.
+void AssignRegisters(ThreeAddressCode& code, const RegisterAllocation& allocation);
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <string>
+
+#include <compiler/ir.h>
+
+struct AssemblyOptions
+{
+    // Name of the generated function.
+    std::string function{ "dragonbook_program" };
+};
+
+// Lowers the code to x86-64 assembly for the System V ABI in GNU as (AT&T)
+// syntax. The result is one function
+//
+//     void dragonbook_program(void* memory);
+//
+// that keeps the variables in its stack frame, laid out by LayOutVariables
+// and zeroed on entry, followed by one 8-byte slot per temporary. When memory
+// is not null, the variables are copied there on return, so the image can be
+// compared with the one left by Execute. Arithmetic is done on 64-bit
+// integers as in the interpreter, but there are no bounds checks and a
+// division by zero raises SIGFPE. Throws std::runtime_error if the frame does
+// not fit in 32-bit displacements.
+std::string GenerateAssembly(const ThreeAddressCode& code, const AssemblyOptions& options = {});
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <list>
+#include <vector>
+#include <memory_resource>
+
+#include <compiler/ir.h>
+#include "memory_arena.h"
+
+// Generated code as a rope of quad chunks. Emitting an instruction appends to
+// the last chunk, joining two buffers splices their chunk lists in O(1), and
+// the program is flattened into one array once, at the end of the compile.
+// The chunks allocate from the CurrentMemoryResource of the moment the buffer
+// is created.
+class CodeBuffer
+{
+public:
+    CodeBuffer()
+        : m_chunks(CurrentMemoryResource())
+    {
+    }
+
+    void Emit(const Quad& quad)
+    {
+        if (m_chunks.empty())
+            m_chunks.emplace_back();
+
+        m_chunks.back().push_back(quad);
+    }
+
+    void Append(CodeBuffer&& other)
+    {
+        m_chunks.splice(m_chunks.end(), other.m_chunks);
+    }
+
+    bool Empty() const
+    {
+        return m_chunks.empty();
+    }
+
+    std::vector<Quad> Flatten() const
+    {
+        size_t size = 0;
+        for (const auto& chunk : m_chunks)
+            size += chunk.size();
+
+        std::vector<Quad> quads;
+        quads.reserve(size);
+        for (const auto& chunk : m_chunks)
+            quads.insert(quads.end(), chunk.begin(), chunk.end());
+
+        return quads;
+    }
+
+private:
+    std::pmr::list<std::pmr::vector<Quad>> m_chunks;
+};
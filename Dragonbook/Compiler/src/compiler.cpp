@@ -1,16 +1,232 @@
+#include <optional>
+#include <algorithm>
+
 #include <compiler/compiler.h>
-#include "grammar_reader.h"
-#include "parser.h"
+#include <compiler/optimizer.h>
+#include <compiler/register_allocator.h>
+#include "compiler_internals.h"
+#include "grammar_cache.h"
 #include "tokenizer.h"
+#include "token_pipeline.h"
+#include "memory_arena.h"
+#include "thread_pool.h"
+#include "program_chunks.h"
 
-std::string Compile(const std::filesystem::path& grammar, std::string&& input)
+void RunPasses(ThreeAddressCode& code, const CompileOptions& options, CompileReport& report)
+{
+    if (options.eliminateCommonSubexpressions)
+        report.eliminatedSubexpressions = EliminateCommonSubexpressions(code);
+
+    if (options.propagateCopies)
+    {
+        report.coalescedCopies = PropagateCopies(code);
+        report.removedDeadCode = EliminateDeadCode(code);
+    }
+
+    if (options.registers > 0)
+    {
+        const RegisterAllocation allocation = AllocateRegisters(code, options.registers);
+        AssignRegisters(code, allocation);
+        report.registersUsed = allocation.registers;
+        report.spillSlots = allocation.spillSlots;
+    }
+
+    if (options.allocateStorage)
+        report.storage = AllocateStorage(code);
+}
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    std::chrono::nanoseconds Since(Clock::time_point start)
+    {
+        return Clock::now() - start;
+    }
+}
+
+Compiler::Compiler()
+{
+    const auto start = Clock::now();
+    auto grammar = std::make_shared<Grammar>(BuiltinGrammar{});
+    grammar->loadTime = Since(start);
+    m_grammar = std::move(grammar);
+}
+
+Compiler::Compiler(const std::filesystem::path& path)
+{
+    const auto start = Clock::now();
+    auto grammar = std::make_shared<Grammar>(LoadGrammar(path, DefaultGrammarCacheDirectory()));
+    grammar->loadTime = Since(start);
+    m_grammar = std::move(grammar);
+}
+
+std::string Compiler::Compile(std::string&& input, const CompileOptions& options, CompileReport* report) const
+{
+    if (!options.collectStatistics || !report)
+        return PrintThreeAddressCode(CompileToIr(std::move(input), options, report));
+
+    const ThreeAddressCode code = CompileToIr(std::move(input), options, report);
+
+    const auto start = Clock::now();
+    std::string text = PrintThreeAddressCode(code);
+    report->statistics.print = Since(start);
+    report->statistics.codeBytes = text.size();
+    return text;
+}
+
+ThreeAddressCode Compiler::CompileToIr(std::string&& input, const CompileOptions& options, CompileReport* report) const
+{
+    const bool collect = options.collectStatistics && report;
+    CompileStatistics statistics;
+    ArenaStatistics arenaStatistics;
+
+    ThreeAddressCode code;
+    if (options.parallelChunks > 1)
+    {
+        // The input is kept to find the first error by a sequential parse if
+        // some chunk fails.
+        std::vector<ProgramChunk> chunks = SplitProgram(Tokenize(std::string{ input }), options.parallelChunks);
+        std::vector<ThreeAddressCode> parts(chunks.size());
+        std::vector<std::exception_ptr> errors(chunks.size());
+
+        // Chunks beyond the hardware threads queue up in the pool.
+        ThreadPool pool(std::min<size_t>(chunks.size(), std::max(1u, std::thread::hardware_concurrency())));
+        for (size_t i = 0; i < chunks.size(); i++)
+        {
+            pool.Submit([this, &options, &chunks, &parts, &errors, i]
+            {
+                try
+                {
+                    parts[i] = m_grammar->Parse(std::move(chunks[i].tokens), options, std::move(chunks[i].symbols));
+                }
+                catch (...)
+                {
+                    errors[i] = std::current_exception();
+                }
+            });
+        }
+        pool.Wait();
+
+        if (std::all_of(errors.begin(), errors.end(), [](const std::exception_ptr& error) { return !error; }))
+            code = MergeChunks(std::move(parts));
+        else
+            code = m_grammar->Parse(Tokenize(std::move(input)), options);
+    }
+    else if (options.pipelineLexer)
+    {
+        TokenPipeline pipeline(std::move(input));
+        try
+        {
+            code = m_grammar->ParseStream([&pipeline] { return pipeline.Next(); }, options, {});
+        }
+        catch (...)
+        {
+            // A lexical error anywhere in the input is reported first.
+            pipeline.Abandon();
+            throw;
+        }
+    }
+    else if (collect || options.useArena)
+    {
+        // Outlives the tokens and the parser, which allocate from it.
+        std::optional<CompileArena> arena;
+        if (options.useArena)
+            arena.emplace();
+
+        auto start = Clock::now();
+        TokenQueue tokens = [&arena, &input]
+        {
+            ScopedMemoryResource scope(arena ? arena->Tokenizer() : CurrentMemoryResource());
+            return Tokenize(std::move(input));
+        }();
+        statistics.tokenize = Since(start);
+        statistics.tokens = tokens.size();
+
+        ParserStatistics parser;
+        start = Clock::now();
+        {
+            ScopedMemoryResource scope(arena ? arena->Parser() : CurrentMemoryResource());
+            code = collect ? m_grammar->Parse(std::move(tokens), options, parser) : m_grammar->Parse(std::move(tokens), options);
+        }
+        statistics.parse = Since(start);
+
+        if (arena)
+            arenaStatistics = arena->Statistics();
+
+        statistics.shifts = parser.shifts;
+        statistics.stackHighWater = parser.stackHighWater;
+        parser.reductions.resize(m_grammar->productions.size(), 0);
+        for (size_t p = 0; p < m_grammar->productions.size(); p++)
+            statistics.reductions.emplace_back(m_grammar->productions[p], parser.reductions[p]);
+    }
+    else
+    {
+        code = m_grammar->Parse(Tokenize(std::move(input)), options);
+    }
+
+    const auto passesStart = collect ? Clock::now() : Clock::time_point{};
+    statistics.temps = code.temps.size();
+
+    CompileReport passes;
+    RunPasses(code, options, passes);
+    passes.arena = arenaStatistics;
+
+    if (collect)
+    {
+        statistics.passes = Since(passesStart);
+        statistics.grammarLoad = m_grammar->loadTime;
+        statistics.quads = code.quads.size();
+        passes.statistics = std::move(statistics);
+    }
+
+    if (report)
+        *report = passes;
+
+    return code;
+}
+
+void Compiler::CompileStream(std::istream& input, std::ostream& output, const CompileOptions& options, size_t chunkSize) const
+{
+    StreamTokenizer tokenizer(input, chunkSize);
+    const auto print = [&output](const ThreeAddressCode& code)
+    {
+        output << PrintThreeAddressCode(code);
+    };
+
+    print(m_grammar->ParseStream([&tokenizer] { return tokenizer.Next(); }, options, print));
+}
+
+std::vector<CompileResult> Compiler::CompileBatch(std::span<const std::string> inputs, const CompileOptions& options, size_t threads) const
 {
-    LalrTable table = ParseGrammarFile(grammar);
+    std::vector<CompileResult> results(inputs.size());
 
-    std::queue<Token> tokens;
-    tokens = Tokenize(std::move(input));
+    ThreadPool pool(std::min(threads == 0 ? std::thread::hardware_concurrency() : threads, std::max<size_t>(inputs.size(), 1)));
+    for (size_t i = 0; i < inputs.size(); i++)
+    {
+        pool.Submit([this, &inputs, &options, &results, i]
+        {
+            try
+            {
+                results[i].code = Compile(std::string{ inputs[i] }, options);
+            }
+            catch (...)
+            {
+                results[i].error = std::current_exception();
+            }
+        });
+    }
+    pool.Wait();
 
-    LrAnalyzer l{ table, tokens };
+    return results;
+}
+
+std::string Compile(const std::filesystem::path& grammar, std::string&& input)
+{
+    return Compiler{ grammar }.Compile(std::move(input));
+}
 
-    return l.Analyze().code.lines;
+std::string Compile(std::string&& input)
+{
+    return Compiler{}.Compile(std::move(input));
 }
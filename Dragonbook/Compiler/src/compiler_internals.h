@@ -0,0 +1,69 @@
+#pragma once
+
+#include <queue>
+#include <chrono>
+#include <variant>
+
+#include <compiler/compiler.h>
+#include "parser.h"
+#include "grammar_tables.h"
+
+// Grammar shared by the copies of a Compiler, with the semantic actions bound
+// to its productions.
+struct Compiler::Grammar
+{
+    template<typename Table>
+    explicit Grammar(Table&& t)
+        : productions(SemanticActions::Productions(t))
+        , actions(SemanticActions::Bind(productions))
+        , table(std::forward<Table>(t))
+    {
+    }
+
+    // Parses a whole program, or a run of statements that follows the
+    // declarations in symbols.
+    ThreeAddressCode Parse(TokenQueue&& tokens, const CompileOptions& options, SymbolTable&& symbols = {}) const
+    {
+        return std::visit(
+            [this, &tokens, &options, &symbols](const auto& t)
+            {
+                LrAnalyzer l{ t, actions, std::move(tokens), options, std::move(symbols) };
+                return l.Analyze();
+            }, table);
+    }
+
+    // Same as Parse, counting the work of the parser into statistics.
+    ThreeAddressCode Parse(TokenQueue&& tokens, const CompileOptions& options, ParserStatistics& statistics) const
+    {
+        return std::visit(
+            [this, &tokens, &options, &statistics](const auto& t)
+            {
+                LrAnalyzer<std::decay_t<decltype(t)>, ParserStatistics> l{ t, actions, std::move(tokens), options };
+                ThreeAddressCode code = l.Analyze();
+                statistics = l.GetStatistics();
+                return code;
+            }, table);
+    }
+
+    // Parses tokens pulled from source, passing the code of each top-level
+    // statement to sink. Returns the code left after the last statement.
+    template<typename Source>
+    ThreeAddressCode ParseStream(Source&& source, const CompileOptions& options, StatementSink&& sink) const
+    {
+        return std::visit(
+            [this, &source, &options, &sink](const auto& t)
+            {
+                LrAnalyzer l{ t, actions, std::forward<Source>(source), options, std::move(sink) };
+                return l.Analyze();
+            }, table);
+    }
+
+    std::vector<std::string> productions;
+    SemanticActions actions;
+    std::variant<BuiltinGrammar, LalrTable> table;
+    // Time taken to load the tables and bind the actions.
+    std::chrono::nanoseconds loadTime{ 0 };
+};
+
+// Runs the passes enabled by options over the parsed code.
+void RunPasses(ThreeAddressCode& code, const CompileOptions& options, CompileReport& report);
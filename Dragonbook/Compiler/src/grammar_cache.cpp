@@ -0,0 +1,163 @@
+#include <atomic>
+#include <thread>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <memory>
+#include <fstream>
+#include <sstream>
+#include <optional>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <unistd.h>
+#include <sys/stat.h>
+#endif
+
+#include "grammar_cache.h"
+
+namespace
+{
+    std::string ReadFile(const std::filesystem::path& file)
+    {
+        std::ifstream f(file, std::ios::binary);
+        if (!f)
+            throw std::runtime_error("Cannot open grammar file '" + file.string() + "'");
+
+        std::ostringstream content;
+        content << f.rdbuf();
+        return content.str();
+    }
+
+    std::filesystem::path CacheFileName(const std::filesystem::path& cacheDirectory, uint64_t sourceHash)
+    {
+        char name[32];
+        std::snprintf(name, sizeof(name), "%016llx.lalr", static_cast<unsigned long long>(sourceHash));
+        return cacheDirectory / name;
+    }
+
+    std::optional<LalrTable> MapCachedTable(const std::filesystem::path& cacheFile, uint64_t sourceHash)
+    {
+        std::error_code ec;
+        if (!std::filesystem::is_regular_file(cacheFile, ec))
+            return std::nullopt;
+
+        try
+        {
+            namespace bip = boost::interprocess;
+
+            const bip::file_mapping file(cacheFile.string().c_str(), bip::read_only);
+            auto region = std::make_shared<bip::mapped_region>(file, bip::read_only);
+            const std::span<const std::byte> image{ static_cast<const std::byte*>(region->get_address()), region->get_size() };
+
+            LalrTable table{ std::move(region), image };
+            if (table.SourceHash() != sourceHash)
+                return std::nullopt;
+
+            return table;
+        }
+        catch (const std::exception&)
+        {
+            // Unreadable, truncated or stale image: rebuild it from the CSV.
+            return std::nullopt;
+        }
+    }
+
+    void StoreCachedTable(const std::filesystem::path& cacheFile, std::span<const std::byte> image)
+    {
+        static std::atomic<unsigned> counter{ 0 };
+
+        std::error_code ec;
+        std::filesystem::create_directories(cacheFile.parent_path(), ec);
+        if (ec)
+            return;
+
+        // Write to a private file and rename it over the cache entry, so that
+        // concurrent readers never map a partially written image.
+        auto tempFile = cacheFile;
+        tempFile += "." + std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id()))
+            + "." + std::to_string(counter++) + ".tmp";
+        {
+            std::ofstream out(tempFile, std::ios::binary | std::ios::trunc);
+            out.write(reinterpret_cast<const char*>(image.data()), static_cast<std::streamsize>(image.size()));
+            if (!out)
+            {
+                out.close();
+                std::filesystem::remove(tempFile, ec);
+                return;
+            }
+        }
+
+        std::filesystem::rename(tempFile, cacheFile, ec);
+        if (ec)
+            std::filesystem::remove(tempFile, ec);
+    }
+
+#ifndef _WIN32
+    // Creates the directory with owner-only permissions if it does not exist.
+    // Returns an empty path, which disables caching, unless the directory is
+    // a real directory owned by the current user and not writable by others.
+    std::filesystem::path PrivateDirectory(const std::filesystem::path& directory)
+    {
+        std::error_code ec;
+        std::filesystem::create_directories(directory.parent_path(), ec);
+        if (::mkdir(directory.c_str(), S_IRWXU) != 0 && errno != EEXIST)
+            return {};
+
+        struct stat info;
+        if (::lstat(directory.c_str(), &info) != 0 || !S_ISDIR(info.st_mode))
+            return {};
+
+        if (info.st_uid != ::geteuid() || (info.st_mode & (S_IWGRP | S_IWOTH)) != 0)
+            return {};
+
+        return directory;
+    }
+#endif
+}
+
+std::filesystem::path DefaultGrammarCacheDirectory()
+{
+#ifdef _WIN32
+    const char* localAppData = std::getenv("LOCALAPPDATA");
+    if (localAppData == nullptr || *localAppData == '\0')
+        return {};
+
+    return std::filesystem::path(localAppData) / "dragonbook" / "grammar-cache";
+#else
+    // Mapped images are trusted once their header matches, so they are only
+    // read from a directory that nobody but the current user can write to.
+    if (const char* xdgCache = std::getenv("XDG_CACHE_HOME"); xdgCache != nullptr && *xdgCache == '/')
+        return PrivateDirectory(std::filesystem::path(xdgCache) / "dragonbook");
+
+    if (const char* home = std::getenv("HOME"); home != nullptr && *home == '/')
+        return PrivateDirectory(std::filesystem::path(home) / ".cache" / "dragonbook");
+
+    std::error_code ec;
+    const auto temp = std::filesystem::temp_directory_path(ec);
+    if (ec)
+        return {};
+
+    return PrivateDirectory(temp / ("dragonbook-grammar-cache-" + std::to_string(::geteuid())));
+#endif
+}
+
+LalrTable LoadGrammar(const std::filesystem::path& grammarFile, const std::filesystem::path& cacheDirectory)
+{
+    const std::string source = ReadFile(grammarFile);
+    const uint64_t sourceHash = HashGrammarSource(source);
+
+    if (cacheDirectory.empty())
+        return ParseGrammar(source);
+
+    const auto cacheFile = CacheFileName(cacheDirectory, sourceHash);
+    if (auto cached = MapCachedTable(cacheFile, sourceHash))
+        return std::move(*cached);
+
+    LalrTable table = ParseGrammar(source);
+    StoreCachedTable(cacheFile, table.Image());
+
+    return table;
+}
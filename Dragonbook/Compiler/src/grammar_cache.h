@@ -0,0 +1,20 @@
+#pragma once
+
+#include <filesystem>
+
+#include "grammar_reader.h"
+
+// Directory used by Compile for precompiled grammar tables: dragonbook under
+// $XDG_CACHE_HOME or ~/.cache, or a per-user directory in the temp directory.
+// The directory is created with owner-only permissions; an empty path, which
+// disables caching, is returned if it is not owned by the current user or is
+// writable by others.
+std::filesystem::path DefaultGrammarCacheDirectory();
+
+// Loads the parse tables for a grammar CSV. A binary image of the table is
+// kept in cacheDirectory under a name derived from the hash of the CSV
+// contents: when it is present it is memory-mapped and used in place,
+// otherwise the CSV is parsed and the image is written for the next run.
+// An empty cacheDirectory disables caching. Failing to write the cache is
+// not an error.
+LalrTable LoadGrammar(const std::filesystem::path& grammarFile, const std::filesystem::path& cacheDirectory);
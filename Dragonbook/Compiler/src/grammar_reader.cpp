@@ -1,14 +1,251 @@
 #include <vector>
 #include <string>
+#include <limits>
 #include <fstream>
+#include <sstream>
+#include <cstring>
+#include <algorithm>
 #include <boost/tokenizer.hpp>
 #include <boost/lexical_cast.hpp>
 
 #include "grammar_reader.h"
 
-LalrTable ParseGrammarFile(const std::filesystem::path& grammarFile)
+namespace
+{
+    struct ParsedProduction
+    {
+        SymbolId lhs{ 0 };
+        std::vector<SymbolId> rhs;
+    };
+
+    uint16_t ToTableValue(const std::string& token)
+    {
+        const auto value = boost::lexical_cast<uint32_t>(token);
+        if (value > std::numeric_limits<uint16_t>::max())
+            throw std::runtime_error("Grammar table value is out of range: '" + token + "'");
+
+        return static_cast<uint16_t>(value);
+    }
+
+    size_t AlignUp(size_t offset, size_t alignment)
+    {
+        return (offset + alignment - 1) / alignment * alignment;
+    }
+
+    template<typename T>
+    T* ImageAt(std::vector<std::byte>& image, size_t offset)
+    {
+        return reinterpret_cast<T*>(image.data() + offset);
+    }
+
+    template<typename T>
+    const T* ImageAt(std::span<const std::byte> image, size_t offset, size_t count)
+    {
+        if (offset % alignof(T) != 0 || offset > image.size() || count > (image.size() - offset) / sizeof(T))
+            throw std::runtime_error("Grammar table image is corrupted");
+
+        return reinterpret_cast<const T*>(image.data() + offset);
+    }
+
+    std::vector<std::byte> BuildImage(uint64_t sourceHash, const std::vector<GrammarSymbol>& symbols,
+        const std::vector<ParsedProduction>& productions, const std::vector<Action>& actions, size_t statesCount)
+    {
+        std::vector<SymbolId> terminalIndex;
+        size_t rhsCount = 0;
+        size_t namesSize = 0;
+        for (size_t i = 0; i < symbols.size(); ++i)
+        {
+            if (!symbols[i].isNonTerminal)
+                terminalIndex.push_back(static_cast<SymbolId>(i));
+            namesSize += symbols[i].str.size();
+        }
+        std::sort(terminalIndex.begin(), terminalIndex.end(),
+            [&symbols](SymbolId lhs, SymbolId rhs) {
+                return symbols[lhs].str < symbols[rhs].str;
+            }
+        );
+
+        for (const auto& p : productions)
+            rhsCount += p.rhs.size();
+
+        TableImageHeader header{};
+        std::memcpy(header.magic, TableImageMagic, sizeof(header.magic));
+        header.version = TableImageVersion;
+        header.sourceHash = sourceHash;
+        header.statesCount = static_cast<uint32_t>(statesCount);
+        header.symbolsCount = static_cast<uint32_t>(symbols.size());
+        header.terminalsCount = static_cast<uint32_t>(terminalIndex.size());
+        header.productionsCount = static_cast<uint32_t>(productions.size());
+
+        size_t offset = sizeof(TableImageHeader);
+        const auto place = [&offset](size_t alignment, size_t bytes)
+        {
+            offset = AlignUp(offset, alignment);
+            const size_t start = offset;
+            offset += bytes;
+            return static_cast<uint32_t>(start);
+        };
+
+        header.symbolsOffset = place(alignof(TableImageSymbol), symbols.size() * sizeof(TableImageSymbol));
+        header.terminalIndexOffset = place(alignof(SymbolId), terminalIndex.size() * sizeof(SymbolId));
+        header.productionsOffset = place(alignof(TableImageProduction), productions.size() * sizeof(TableImageProduction));
+        header.rhsOffset = place(alignof(SymbolId), rhsCount * sizeof(SymbolId));
+        header.actionsOffset = place(alignof(Action), actions.size() * sizeof(Action));
+        header.namesOffset = place(1, namesSize);
+
+        if (offset > std::numeric_limits<uint32_t>::max())
+            throw std::runtime_error("Grammar table is too large");
+        header.size = static_cast<uint32_t>(AlignUp(offset, alignof(TableImageHeader)));
+
+        std::vector<std::byte> image(header.size);
+        *ImageAt<TableImageHeader>(image, 0) = header;
+
+        uint32_t nameOffset = 0;
+        for (size_t i = 0; i < symbols.size(); ++i)
+        {
+            auto& symbol = ImageAt<TableImageSymbol>(image, header.symbolsOffset)[i];
+            symbol.nameOffset = nameOffset;
+            symbol.nameLength = static_cast<uint16_t>(symbols[i].str.size());
+            symbol.isNonTerminal = symbols[i].isNonTerminal ? 1 : 0;
+
+            std::memcpy(ImageAt<char>(image, header.namesOffset) + nameOffset, symbols[i].str.data(), symbols[i].str.size());
+            nameOffset += static_cast<uint32_t>(symbols[i].str.size());
+        }
+
+        std::copy(terminalIndex.begin(), terminalIndex.end(), ImageAt<SymbolId>(image, header.terminalIndexOffset));
+
+        uint32_t rhsIndex = 0;
+        for (size_t i = 0; i < productions.size(); ++i)
+        {
+            auto& production = ImageAt<TableImageProduction>(image, header.productionsOffset)[i];
+            production.rhsIndex = rhsIndex;
+            production.lhs = productions[i].lhs;
+            production.length = static_cast<uint16_t>(productions[i].rhs.size());
+
+            std::copy(productions[i].rhs.begin(), productions[i].rhs.end(), ImageAt<SymbolId>(image, header.rhsOffset) + rhsIndex);
+            rhsIndex += production.length;
+        }
+
+        // Field by field, so that the padding byte of Action stays zero and the
+        // image bytes depend only on the grammar.
+        for (size_t i = 0; i < actions.size(); ++i)
+        {
+            auto& action = ImageAt<Action>(image, header.actionsOffset)[i];
+            action.type = actions[i].type;
+            action.value = actions[i].value;
+        }
+
+        return image;
+    }
+}
+
+LalrTable::LalrTable(std::shared_ptr<const void> storage, std::span<const std::byte> image)
+    : m_storage(std::move(storage))
+    , m_image(image)
+{
+    m_header = ImageAt<TableImageHeader>(m_image, 0, 1);
+    if (std::memcmp(m_header->magic, TableImageMagic, sizeof(TableImageMagic)) != 0)
+        throw std::runtime_error("Not a grammar table image");
+
+    if (m_header->version != TableImageVersion || m_header->size != m_image.size())
+        throw std::runtime_error("Grammar table image has incompatible format");
+
+    const size_t symbolsCount = m_header->symbolsCount;
+    m_symbols = ImageAt<TableImageSymbol>(m_image, m_header->symbolsOffset, symbolsCount);
+    m_terminalIndex = ImageAt<SymbolId>(m_image, m_header->terminalIndexOffset, m_header->terminalsCount);
+    m_productions = ImageAt<TableImageProduction>(m_image, m_header->productionsOffset, m_header->productionsCount);
+    m_actions = ImageAt<Action>(m_image, m_header->actionsOffset, m_header->statesCount * symbolsCount);
+    m_names = ImageAt<char>(m_image, m_header->namesOffset, 0);
+
+    size_t rhsCount = 0;
+    for (size_t i = 0; i < m_header->productionsCount; ++i)
+        rhsCount = std::max(rhsCount, size_t{ m_productions[i].rhsIndex } + m_productions[i].length);
+    m_rhs = ImageAt<SymbolId>(m_image, m_header->rhsOffset, rhsCount);
+
+    ValidateIndexes();
+}
+
+void LalrTable::ValidateIndexes() const
 {
-    std::ifstream g(grammarFile);
+    // The accessors and the parser index with these values unchecked, so an
+    // image is accepted only if every index in it stays in range.
+    const auto check = [](bool valid) {
+        if (!valid)
+            throw std::runtime_error("Grammar table image is corrupted");
+    };
+
+    const size_t symbolsCount = m_header->symbolsCount;
+    const size_t statesCount = m_header->statesCount;
+    const size_t productionsCount = m_header->productionsCount;
+    check(symbolsCount <= size_t{ std::numeric_limits<SymbolId>::max() } + 1 && statesCount != 0);
+
+    const size_t namesSize = m_image.size() - m_header->namesOffset;
+    for (size_t i = 0; i < symbolsCount; ++i)
+        check(size_t{ m_symbols[i].nameOffset } + m_symbols[i].nameLength <= namesSize);
+
+    for (size_t i = 0; i < m_header->terminalsCount; ++i)
+    {
+        check(m_terminalIndex[i] < symbolsCount && !IsNonTerminal(m_terminalIndex[i]));
+        check(i == 0 || SymbolName(m_terminalIndex[i - 1]) <= SymbolName(m_terminalIndex[i]));
+    }
+
+    for (size_t i = 0; i < productionsCount; ++i)
+    {
+        check(m_productions[i].lhs < symbolsCount && IsNonTerminal(m_productions[i].lhs));
+        for (const SymbolId symbol : ProductionRhs(i))
+            check(symbol < symbolsCount);
+    }
+
+    for (size_t i = 0; i < statesCount * symbolsCount; ++i)
+    {
+        switch (m_actions[i].type)
+        {
+        case Action::Type::Shift:
+            check(m_actions[i].value < statesCount);
+            break;
+        case Action::Type::Reduce:
+            check(m_actions[i].value < productionsCount);
+            break;
+        case Action::Type::Error:
+        case Action::Type::Accept:
+            break;
+        default:
+            check(false);
+        }
+    }
+}
+
+std::optional<SymbolId> LalrTable::FindTerminal(std::string_view name) const
+{
+    const auto begin = m_terminalIndex;
+    const auto end = m_terminalIndex + m_header->terminalsCount;
+    const auto it = std::lower_bound(begin, end, name,
+        [this](SymbolId symbol, std::string_view value) {
+            return SymbolName(symbol) < value;
+        }
+    );
+
+    if (it == end || SymbolName(*it) != name)
+        return std::nullopt;
+
+    return *it;
+}
+
+uint64_t HashGrammarSource(std::string_view source)
+{
+    // 64-bit FNV-1a
+    uint64_t hash = 14695981039346656037ull;
+    for (const char c : source)
+    {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+LalrTable ParseGrammar(std::string_view source)
+{
+    std::istringstream g{ std::string(source) };
 
     std::string header;
     std::getline(g, header);
@@ -40,7 +277,10 @@ LalrTable ParseGrammarFile(const std::filesystem::path& grammarFile)
         }
     }
 
-    std::vector<Reduce> reduces;
+    if (termsAndNonTerms.size() > std::numeric_limits<SymbolId>::max())
+        throw std::runtime_error("Too many symbols in grammar");
+
+    std::vector<ParsedProduction> productions;
     {
         std::string line;
         std::getline(g, line);
@@ -49,12 +289,19 @@ LalrTable ParseGrammarFile(const std::filesystem::path& grammarFile)
             boost::char_separator<char> sep{" "};
             boost::tokenizer<decltype(sep)> tokenizer(line, sep);
 
-            Reduce r;
+            ParsedProduction p;
+            bool first = true;
             for (const auto& token : tokenizer)
             {
-                if (r.from.nonTerm.empty())
+                if (first)
                 {
-                    r.from.nonTerm = token;
+                    first = false;
+
+                    const auto it = std::find(termsAndNonTerms.begin(), termsAndNonTerms.end(), GrammarSymbol{ true, token });
+                    if (it == termsAndNonTerms.end())
+                        throw std::runtime_error("Unknown non terminal in grammar: '" + token + "'");
+
+                    p.lhs = static_cast<SymbolId>(it - termsAndNonTerms.begin());
                     continue;
                 }
 
@@ -69,26 +316,32 @@ LalrTable ParseGrammarFile(const std::filesystem::path& grammarFile)
 
                 if (it != termsAndNonTerms.end())
                 {
-                    r.to.push_back(*it);
+                    p.rhs.push_back(static_cast<SymbolId>(it - termsAndNonTerms.begin()));
                 }
                 else
                 {
                     throw std::runtime_error("Unknown token in grammar: '" + token + "'");
                 }
             }
-            reduces.push_back(r);
+            productions.push_back(p);
         }
     }
 
-    LalrTable table;
+    std::vector<Action> actions;
+    size_t statesCount = 0;
     {
-        size_t num = 0;
         std::string line;
         while (std::getline(g, line))
         {
+            if (line.empty())
+                continue;
+
             boost::char_separator<char> sep("", ",", boost::drop_empty_tokens);
             boost::tokenizer<boost::char_separator<char>> tokenizer(line, sep);
 
+            const size_t rowStart = actions.size();
+            actions.resize(rowStart + termsAndNonTerms.size());
+
             bool first = true;
             size_t counter = 0;
             for (const auto& token : tokenizer)
@@ -105,32 +358,50 @@ LalrTable ParseGrammarFile(const std::filesystem::path& grammarFile)
                     continue;
                 }
 
+                if (counter == 0 || counter > termsAndNonTerms.size())
+                    throw std::runtime_error("Malformed grammar table row: '" + line + "'");
+
+                Action& action = actions[rowStart + counter - 1];
                 if (token.front() == 's')
                 {
-                    const auto stateInt = boost::lexical_cast<uint32_t>(token.substr(1));
-                    const auto action = Shift{ stateInt };
-                    table.insert({ { State{num}, termsAndNonTerms[counter - 1] }, action });
+                    action = Action{ Action::Type::Shift, ToTableValue(token.substr(1)) };
                 }
                 else if (token.front() == 'r')
                 {
-                    const auto reduceInt = boost::lexical_cast<uint32_t>(token.substr(1));
-                    const auto action = reduces[reduceInt];
-                    table.insert({ { State{num}, termsAndNonTerms[counter - 1] }, action });
+                    const auto reduceInt = ToTableValue(token.substr(1));
+                    if (reduceInt >= productions.size())
+                        throw std::runtime_error("Unknown production in grammar table: '" + token + "'");
+
+                    action = Action{ Action::Type::Reduce, reduceInt };
                 }
                 else if (token == "acc")
                 {
-                    table.insert({ { State{num}, termsAndNonTerms[counter - 1] }, Accept{} });
+                    action = Action{ Action::Type::Accept };
                 }
                 else if (!token.empty())
                 {
-                    const auto stateInt = boost::lexical_cast<uint32_t>(token);
-                    const auto action = Shift{ stateInt };
-                    table.insert({ { State{num}, termsAndNonTerms[counter - 1] }, action });
+                    action = Action{ Action::Type::Shift, ToTableValue(token) };
                 }
             }
-            num++;
+            statesCount++;
         }
     }
 
-    return table;
-}
\ No newline at end of file
+    auto image = std::make_shared<std::vector<std::byte>>(
+        BuildImage(HashGrammarSource(source), termsAndNonTerms, productions, actions, statesCount));
+    const std::span<const std::byte> bytes{ image->data(), image->size() };
+
+    return LalrTable{ std::move(image), bytes };
+}
+
+LalrTable ParseGrammarFile(const std::filesystem::path& grammarFile)
+{
+    std::ifstream g(grammarFile, std::ios::binary);
+    if (!g)
+        throw std::runtime_error("Cannot open grammar file '" + grammarFile.string() + "'");
+
+    std::ostringstream source;
+    source << g.rdbuf();
+
+    return ParseGrammar(source.str());
+}
@@ -1,8 +1,15 @@
 #pragma once
 
 #include <map>
-#include <variant>
+#include <span>
+#include <memory>
+#include <vector>
+#include <string>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
 #include <filesystem>
+#include <string_view>
 
 struct GrammarSymbol
 {
@@ -24,23 +31,124 @@ struct GrammarSymbol
 };
 
 using State = size_t;
+using SymbolId = uint16_t;
 
-struct NonTerminal { std::string nonTerm; };
+struct Action
+{
+    enum class Type : uint8_t
+    {
+        Error,
+        Shift,
+        Reduce,
+        Accept
+    };
+
+    Type type{ Type::Error };
+    // Target state for Shift (and GOTO entries), production index for Reduce.
+    uint16_t value{ 0 };
+};
+
+// Parse tables are kept in one flat, position-independent image. The same
+// bytes are built in memory from the CSV, written to the grammar cache and
+// mapped back from it, so a cached table is used in place without a
+// deserialization pass. All offsets are in bytes from the start of the image.
+constexpr char TableImageMagic[8] = { 'D', 'B', 'L', 'A', 'L', 'R', 'T', '\0' };
+constexpr uint32_t TableImageVersion = 1;
+
+struct TableImageHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t size;
+    uint64_t sourceHash;
+    uint32_t statesCount;
+    uint32_t symbolsCount;
+    uint32_t terminalsCount;
+    uint32_t productionsCount;
+    uint32_t symbolsOffset;       // TableImageSymbol[symbolsCount]
+    uint32_t terminalIndexOffset; // SymbolId[terminalsCount], sorted by name
+    uint32_t productionsOffset;   // TableImageProduction[productionsCount]
+    uint32_t rhsOffset;           // SymbolId[], right-hand sides of all productions
+    uint32_t actionsOffset;       // Action[statesCount * symbolsCount], row-major
+    uint32_t namesOffset;         // symbol names, not null-terminated
+};
 
-struct Reduce
+struct TableImageSymbol
 {
-    NonTerminal from;
-    std::vector<GrammarSymbol> to;
+    uint32_t nameOffset;
+    uint16_t nameLength;
+    uint8_t isNonTerminal;
+    uint8_t reserved;
 };
 
-struct Shift
+struct TableImageProduction
 {
-    State st;
+    uint32_t rhsIndex;
+    SymbolId lhs;
+    uint16_t length;
 };
 
-struct Accept {};
+// ACTION and GOTO tables packed into one dense row-major matrix indexed by
+// state and symbol ID, plus the grammar productions. Symbol IDs follow the
+// column order of the grammar file. The table is a read-only view over an
+// image; copies share the underlying storage.
+class LalrTable
+{
+public:
+    // Throws if the image is truncated, was written by another format version
+    // or holds a state, production or symbol index that is out of range.
+    LalrTable(std::shared_ptr<const void> storage, std::span<const std::byte> image);
+
+    const Action& At(State state, SymbolId symbol) const
+    {
+        return m_actions[state * m_header->symbolsCount + symbol];
+    }
+
+    std::optional<SymbolId> FindTerminal(std::string_view name) const;
+
+    size_t StatesCount() const { return m_header->statesCount; }
+    size_t SymbolsCount() const { return m_header->symbolsCount; }
+    size_t ProductionsCount() const { return m_header->productionsCount; }
+
+    std::string_view SymbolName(SymbolId symbol) const
+    {
+        return { m_names + m_symbols[symbol].nameOffset, m_symbols[symbol].nameLength };
+    }
+
+    bool IsNonTerminal(SymbolId symbol) const
+    {
+        return m_symbols[symbol].isNonTerminal != 0;
+    }
+
+    SymbolId ProductionLhs(size_t production) const
+    {
+        return m_productions[production].lhs;
+    }
+
+    std::span<const SymbolId> ProductionRhs(size_t production) const
+    {
+        return { m_rhs + m_productions[production].rhsIndex, m_productions[production].length };
+    }
+
+    uint64_t SourceHash() const { return m_header->sourceHash; }
+    std::span<const std::byte> Image() const { return m_image; }
+
+private:
+    void ValidateIndexes() const;
+
+    std::shared_ptr<const void> m_storage;
+    std::span<const std::byte> m_image;
+
+    const TableImageHeader* m_header;
+    const TableImageSymbol* m_symbols;
+    const SymbolId* m_terminalIndex;
+    const TableImageProduction* m_productions;
+    const SymbolId* m_rhs;
+    const Action* m_actions;
+    const char* m_names;
+};
 
-using Action = std::variant<Shift, Reduce, Accept>;
-using LalrTable = std::map<std::pair<State, GrammarSymbol>, Action>;
+uint64_t HashGrammarSource(std::string_view source);
 
+LalrTable ParseGrammar(std::string_view source);
 LalrTable ParseGrammarFile(const std::filesystem::path& grammarFile);
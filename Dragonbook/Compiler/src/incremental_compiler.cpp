@@ -0,0 +1,247 @@
+#include <algorithm>
+#include <unordered_set>
+
+#include <compiler/incremental_compiler.h>
+#include "compiler_internals.h"
+#include "program_chunks.h"
+#include "tokenizer.h"
+
+struct IncrementalCompiler::Unit
+{
+    // Position of the unit in the text, from the end of the previous unit to
+    // the ; of its assignment.
+    size_t begin{ 0 };
+    size_t end{ 0 };
+
+    // Code of the unit alone, with its own variable, temporary and constant
+    // tables.
+    ThreeAddressCode code;
+    // Symbols declared by the unit and the identifiers it uses.
+    SymbolTable declared;
+    std::unordered_set<std::string> names;
+
+    // Tokens of a unit that is about to be parsed.
+    std::vector<Token> tokens;
+    // Whether the unit ends with an assignment; only the last unit of a
+    // program may not.
+    bool complete{ false };
+};
+
+struct IncrementalCompiler::Units
+{
+    std::string text;
+    std::vector<Unit> list;
+};
+
+IncrementalCompiler::IncrementalCompiler(Compiler compiler, CompileOptions options)
+    : m_compiler(std::move(compiler))
+    , m_options(options)
+    , m_units(std::make_unique<Units>())
+{
+}
+
+IncrementalCompiler::~IncrementalCompiler() = default;
+IncrementalCompiler::IncrementalCompiler(IncrementalCompiler&&) noexcept = default;
+IncrementalCompiler& IncrementalCompiler::operator=(IncrementalCompiler&&) noexcept = default;
+
+const IncrementalCompiler::Statistics& IncrementalCompiler::LastCompile() const
+{
+    return m_statistics;
+}
+
+std::string IncrementalCompiler::Compile(const std::string& input, CompileReport* report)
+{
+    return PrintThreeAddressCode(CompileToIr(input, report));
+}
+
+ThreeAddressCode IncrementalCompiler::CompileToIr(const std::string& input, CompileReport* report)
+{
+    // Splits text[begin, end) into units. Every statement is tokenized on its
+    // own, as ; never is a part of a longer token.
+    const auto split = [&input](size_t begin, size_t end)
+    {
+        std::vector<Unit> units;
+        Unit unit;
+        unit.begin = begin;
+
+        for (size_t pos = begin; pos < end;)
+        {
+            const size_t semicolon = input.find(';', pos);
+            const size_t next = (semicolon < end) ? semicolon + 1 : end;
+
+            TokenQueue queue = Tokenize(input.substr(pos, next - pos));
+            std::vector<Token> statement;
+            for (; !queue.empty(); queue.pop())
+                statement.push_back(std::move(queue.front()));
+
+            CollectDeclaration(unit.declared, statement);
+            for (const Token& token : statement)
+            {
+                if (token.first == "id")
+                    unit.names.insert(token.second);
+            }
+
+            const bool assignment = !statement.empty() && statement.front().first == "id" && statement.back().first == ";";
+            unit.tokens.insert(unit.tokens.end(), std::make_move_iterator(statement.begin()), std::make_move_iterator(statement.end()));
+            pos = next;
+
+            if (assignment)
+            {
+                unit.end = pos;
+                unit.complete = true;
+                units.push_back(std::move(unit));
+                unit = Unit{};
+                unit.begin = pos;
+            }
+        }
+
+        if (unit.begin < end)
+        {
+            unit.end = end;
+            units.push_back(std::move(unit));
+        }
+
+        return units;
+    };
+
+    try
+    {
+        std::vector<Unit>& old = m_units->list;
+        const std::string& oldText = m_units->text;
+
+        const size_t prefix = static_cast<size_t>(std::mismatch(oldText.begin(), oldText.end(), input.begin(), input.end()).first - oldText.begin());
+        const size_t suffixLimit = std::min(oldText.size(), input.size()) - prefix;
+        const size_t suffix = static_cast<size_t>(std::mismatch(oldText.rbegin(), oldText.rbegin() + suffixLimit, input.rbegin()).first - oldText.rbegin());
+
+        // Units [0, first) lie in the common prefix, units [last, ...) in the
+        // common suffix; the text between them is split again.
+        const size_t first = std::partition_point(old.begin(), old.end(), [prefix](const Unit& u) { return u.end <= prefix; }) - old.begin();
+        size_t last = std::max(first, static_cast<size_t>(std::partition_point(old.begin(), old.end(),
+            [&](const Unit& u) { return u.begin < oldText.size() - suffix; }) - old.begin()));
+
+        const auto shift = [&](size_t position) { return position + input.size() - oldText.size(); };
+        const size_t regionBegin = first > 0 ? old[first - 1].end : 0;
+
+        std::vector<Unit> fresh;
+        for (;;)
+        {
+            const size_t regionEnd = last < old.size() ? shift(old[last].begin) : input.size();
+            fresh = split(regionBegin, regionEnd);
+
+            // The changed text must end where a unit ends to be followed by the
+            // units kept from the suffix.
+            if (last < old.size() && !fresh.empty() && !fresh.back().complete)
+            {
+                last++;
+                continue;
+            }
+            break;
+        }
+
+        // Names whose declarations may have changed.
+        std::unordered_set<std::string> redeclared;
+        const auto collect = [&redeclared](const Unit& unit)
+        {
+            for (NameId name = 0; name < unit.declared.Size(); name++)
+                redeclared.insert(unit.declared.Name(name));
+        };
+        std::for_each(old.begin() + first, old.begin() + last, collect);
+        std::for_each(fresh.begin(), fresh.end(), collect);
+
+        std::vector<Unit> units;
+        units.reserve(first + fresh.size() + old.size() - last);
+        std::move(old.begin(), old.begin() + first, std::back_inserter(units));
+        std::move(fresh.begin(), fresh.end(), std::back_inserter(units));
+
+        std::vector<bool> stale(first, false);
+        stale.resize(units.size(), true);
+
+        for (size_t i = last; i < old.size(); i++)
+        {
+            Unit& unit = old[i];
+            unit.begin = shift(unit.begin);
+            unit.end = shift(unit.end);
+
+            const bool dependent = !redeclared.empty() && std::any_of(unit.names.begin(), unit.names.end(),
+                [&redeclared](const std::string& name) { return redeclared.contains(name); });
+
+            if (dependent)
+            {
+                TokenQueue queue = Tokenize(input.substr(unit.begin, unit.end - unit.begin));
+                for (; !queue.empty(); queue.pop())
+                    unit.tokens.push_back(std::move(queue.front()));
+            }
+
+            units.push_back(std::move(unit));
+            stale.push_back(dependent);
+        }
+
+        // Declarations of every name in program order; they are declared
+        // again in that order so that the first one stays in effect.
+        std::unordered_map<std::string, std::vector<std::pair<size_t, const TypeDescriptor*>>> declarations;
+        for (size_t i = 0; i < units.size(); i++)
+        {
+            const SymbolTable& declared = units[i].declared;
+            for (NameId name = 0; name < declared.Size(); name++)
+                declarations[declared.Name(name)].emplace_back(i, declared.TypeOf(name));
+        }
+
+        m_statistics = Statistics{};
+        for (size_t i = 0; i < units.size(); i++)
+        {
+            if (!stale[i])
+            {
+                m_statistics.reusedUnits++;
+                continue;
+            }
+
+            // Only the symbols the unit refers to, as declared before it.
+            SymbolTable symbols;
+            for (const std::string& name : units[i].names)
+            {
+                const auto it = declarations.find(name);
+                if (it == declarations.end())
+                    continue;
+
+                for (const auto& [unit, type] : it->second)
+                {
+                    if (unit >= i)
+                        break;
+                    symbols.Declare(name, *type);
+                }
+            }
+
+            TokenQueue tokens;
+            for (Token& token : units[i].tokens)
+                tokens.push(std::move(token));
+            units[i].tokens = {};
+
+            units[i].code = tokens.empty() ? ThreeAddressCode{} : m_compiler.m_grammar->Parse(std::move(tokens), m_options, std::move(symbols));
+            m_statistics.compiledUnits++;
+        }
+
+        ChunkMerger merger;
+        for (const Unit& unit : units)
+            merger.Append(unit.code);
+
+        ThreeAddressCode code = merger.Finish();
+
+        m_units->list = std::move(units);
+        m_units->text = input;
+
+        CompileReport passes;
+        RunPasses(code, m_options, passes);
+        if (report)
+            *report = passes;
+
+        return code;
+    }
+    catch (...)
+    {
+        // Start over, and let the whole-program compile report the error the
+        // way it always does.
+        m_units = std::make_unique<Units>();
+        m_statistics = Statistics{};
+        return m_compiler.CompileToIr(std::string{ input }, m_options, report);
+    }
+}
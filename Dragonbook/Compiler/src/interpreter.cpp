@@ -0,0 +1,325 @@
+#include <limits>
+#include <cstring>
+#include <stdexcept>
+
+#include <compiler/interpreter.h>
+#include <compiler/memory_layout.h>
+
+#if defined(__GNUC__)
+#define COMPILER_COMPUTED_GOTO
+#endif
+
+namespace
+{
+    enum class Operation : uint8_t
+    {
+        Add,
+        Sub,
+        Mul,
+        Div,
+        Copy,
+        LoadInt,
+        LoadFloat,
+        Address,
+        StoreInt,
+        StoreFloat,
+        RoundFloat,
+        Halt
+    };
+
+    struct Instruction
+    {
+        Operation operation{ Operation::Halt };
+        const void* target{ nullptr };
+        int64_t* result{ nullptr };
+        const int64_t* lhs{ nullptr };
+        const int64_t* rhs{ nullptr };
+        // Offset of the array in memory for LoadInt, LoadFloat and Address.
+        int64_t base{ 0 };
+    };
+
+    // Truncates like cvttss2si, which gives the smallest int64 for values out
+    // of its range.
+    int64_t FloatToInt(float value)
+    {
+        constexpr float limit = 9223372036854775808.0f;
+        if (!(value >= -limit && value < limit))
+            return std::numeric_limits<int64_t>::min();
+        return static_cast<int64_t>(value);
+    }
+
+    int64_t ReadElement(const std::vector<std::byte>& memory, int64_t address, bool isFloat)
+    {
+        const size_t size = isFloat ? sizeof(float) : sizeof(int64_t);
+        if (address < 0 || static_cast<size_t>(address) + size > memory.size())
+            throw std::runtime_error("Memory access out of bounds: " + std::to_string(address));
+
+        if (isFloat)
+        {
+            float value;
+            std::memcpy(&value, memory.data() + address, sizeof(value));
+            return FloatToInt(value);
+        }
+
+        int64_t value;
+        std::memcpy(&value, memory.data() + address, sizeof(value));
+        return value;
+    }
+
+    void WriteElement(std::vector<std::byte>& memory, int64_t address, bool isFloat, int64_t value)
+    {
+        const size_t size = isFloat ? sizeof(float) : sizeof(int64_t);
+        if (address < 0 || static_cast<size_t>(address) + size > memory.size())
+            throw std::runtime_error("Memory access out of bounds: " + std::to_string(address));
+
+        if (isFloat)
+        {
+            const float element = static_cast<float>(value);
+            std::memcpy(memory.data() + address, &element, sizeof(element));
+        }
+        else
+        {
+            std::memcpy(memory.data() + address, &value, sizeof(value));
+        }
+    }
+
+    // Scalars, temporaries and constants live in one array of values while the
+    // program runs; only arrays are accessed in the memory image.
+    class Machine
+    {
+    public:
+        explicit Machine(const ThreeAddressCode& code, ExecutionResult& result)
+            : m_code(code)
+            , m_result(result)
+            , m_values(code.variables.size() + code.temps.size() + code.constants.size(), 0)
+        {
+            MemoryLayout layout = LayOutVariables(code);
+            result.memory.resize(layout.size);
+            result.offsets = std::move(layout.offsets);
+            result.variables = code.variables;
+
+            for (size_t i = 0; i < code.constants.size(); i++)
+                m_values[code.variables.size() + code.temps.size() + i] = ConstantValue(code.constants[i]);
+        }
+
+        void Decode()
+        {
+            // Width of the element each address temporary points to; the code
+            // is straight-line, so the latest Address defining it is the one.
+            std::vector<bool> floatAddress(m_code.temps.size(), false);
+
+            m_program.reserve(m_code.quads.size() + 1);
+            for (const Quad& quad : m_code.quads)
+            {
+                Instruction instruction;
+                switch (quad.op)
+                {
+                case OpCode::Add:
+                    instruction.operation = Operation::Add;
+                    break;
+                case OpCode::Sub:
+                    instruction.operation = Operation::Sub;
+                    break;
+                case OpCode::Mul:
+                    instruction.operation = Operation::Mul;
+                    break;
+                case OpCode::Div:
+                    instruction.operation = Operation::Div;
+                    break;
+                case OpCode::Copy:
+                    instruction.operation = Operation::Copy;
+                    break;
+                case OpCode::Load:
+                    instruction.operation = IsFloat(Array(quad.arg1)) ? Operation::LoadFloat : Operation::LoadInt;
+                    instruction.base = static_cast<int64_t>(m_result.offsets[quad.arg1.id]);
+                    break;
+                case OpCode::Address:
+                    instruction.operation = Operation::Address;
+                    instruction.base = static_cast<int64_t>(m_result.offsets[quad.arg1.id]);
+                    if (quad.result.kind == Operand::Kind::Temp)
+                        floatAddress[quad.result.id] = IsFloat(Array(quad.arg1));
+                    break;
+                case OpCode::Store:
+                    instruction.operation = (quad.result.kind == Operand::Kind::Temp && floatAddress[quad.result.id]) ? Operation::StoreFloat : Operation::StoreInt;
+                    break;
+                }
+
+                instruction.result = Slot(quad.result);
+                if (quad.op != OpCode::Load && quad.op != OpCode::Address)
+                    instruction.lhs = Slot(quad.arg1);
+                instruction.rhs = Slot(quad.arg2);
+                m_program.push_back(instruction);
+
+                // A float variable only holds what a float can represent.
+                if (quad.op != OpCode::Store && quad.result.kind == Operand::Kind::Variable && IsFloat(m_code.variables[quad.result.id]))
+                    m_program.push_back(Instruction{ Operation::RoundFloat, nullptr, Slot(quad.result) });
+            }
+            m_program.push_back(Instruction{});
+        }
+
+        void Run();
+
+        // Writes the final values of the scalars into the memory image.
+        void Finish()
+        {
+            for (size_t i = 0; i < m_code.variables.size(); i++)
+            {
+                const IrVariable& variable = m_code.variables[i];
+                if (!IsArray(variable))
+                    WriteElement(m_result.memory, static_cast<int64_t>(m_result.offsets[i]), IsFloat(variable), m_values[i]);
+            }
+        }
+
+    private:
+        const IrVariable& Array(const Operand& operand) const
+        {
+            if (operand.kind != Operand::Kind::Variable || !IsArray(m_code.variables[operand.id]))
+                throw std::runtime_error("Array expected: " + OperandName(m_code, operand));
+            return m_code.variables[operand.id];
+        }
+
+        int64_t* Slot(const Operand& operand)
+        {
+            switch (operand.kind)
+            {
+            case Operand::Kind::Variable:
+                return &m_values[operand.id];
+            case Operand::Kind::Temp:
+                return &m_values[m_code.variables.size() + operand.id];
+            case Operand::Kind::Constant:
+                return &m_values[m_code.variables.size() + m_code.temps.size() + operand.id];
+            case Operand::Kind::None:
+                break;
+            }
+            return nullptr;
+        }
+
+        const ThreeAddressCode& m_code;
+        ExecutionResult& m_result;
+        std::vector<int64_t> m_values;
+        std::vector<Instruction> m_program;
+    };
+
+    int64_t Divide(int64_t lhs, int64_t rhs)
+    {
+        if (rhs == 0)
+            throw std::runtime_error("Division by zero");
+        if (rhs == -1)
+            return static_cast<int64_t>(0 - static_cast<uint64_t>(lhs));
+        return lhs / rhs;
+    }
+
+    // Integer overflow wraps around instead of being undefined.
+    int64_t Wrap(uint64_t value)
+    {
+        return static_cast<int64_t>(value);
+    }
+
+    void Machine::Run()
+    {
+        auto& memory = m_result.memory;
+
+#ifdef COMPILER_COMPUTED_GOTO
+        // Indexed by Operation.
+        static const void* const targets[] = {
+            &&add, &&sub, &&mul, &&div, &&copy, &&loadInt, &&loadFloat, &&address, &&storeInt, &&storeFloat, &&roundFloat, &&halt
+        };
+
+        for (Instruction& instruction : m_program)
+            instruction.target = targets[static_cast<size_t>(instruction.operation)];
+
+        const Instruction* ip = m_program.data();
+
+#define DISPATCH() goto *(++ip)->target
+#define CASE(label, operation) label:
+        goto *ip->target;
+#else
+        const Instruction* ip = m_program.data() - 1;
+
+#define DISPATCH() break
+#define CASE(label, operation) case Operation::operation:
+        for (;;)
+        {
+            switch ((++ip)->operation)
+            {
+#endif
+        CASE(add, Add)
+            *ip->result = Wrap(static_cast<uint64_t>(*ip->lhs) + static_cast<uint64_t>(*ip->rhs));
+            DISPATCH();
+        CASE(sub, Sub)
+            *ip->result = Wrap(static_cast<uint64_t>(*ip->lhs) - static_cast<uint64_t>(*ip->rhs));
+            DISPATCH();
+        CASE(mul, Mul)
+            *ip->result = Wrap(static_cast<uint64_t>(*ip->lhs) * static_cast<uint64_t>(*ip->rhs));
+            DISPATCH();
+        CASE(div, Div)
+            *ip->result = Divide(*ip->lhs, *ip->rhs);
+            DISPATCH();
+        CASE(copy, Copy)
+            *ip->result = *ip->lhs;
+            DISPATCH();
+        CASE(loadInt, LoadInt)
+            *ip->result = ReadElement(memory, ip->base + *ip->rhs, false);
+            DISPATCH();
+        CASE(loadFloat, LoadFloat)
+            *ip->result = ReadElement(memory, ip->base + *ip->rhs, true);
+            DISPATCH();
+        CASE(address, Address)
+            *ip->result = ip->base + *ip->rhs;
+            DISPATCH();
+        CASE(storeInt, StoreInt)
+            WriteElement(memory, *ip->result, false, *ip->lhs);
+            DISPATCH();
+        CASE(storeFloat, StoreFloat)
+            WriteElement(memory, *ip->result, true, *ip->lhs);
+            DISPATCH();
+        CASE(roundFloat, RoundFloat)
+            *ip->result = FloatToInt(static_cast<float>(*ip->result));
+            DISPATCH();
+        CASE(halt, Halt)
+            return;
+#ifndef COMPILER_COMPUTED_GOTO
+            }
+        }
+#endif
+
+#undef DISPATCH
+#undef CASE
+    }
+}
+
+double ExecutionResult::InstructionsPerSecond() const
+{
+    const double seconds = std::chrono::duration<double>(elapsed).count();
+    return seconds > 0 ? static_cast<double>(instructions) / seconds : 0.0;
+}
+
+int64_t ExecutionResult::Value(const std::string& name, size_t offset) const
+{
+    for (size_t i = 0; i < variables.size(); i++)
+    {
+        if (variables[i].name != name)
+            continue;
+
+        if (offset + ElementSize(variables[i]) > StorageSize(variables[i]))
+            throw std::out_of_range("Offset " + std::to_string(offset) + " is outside of '" + name + "'");
+
+        return ReadElement(memory, static_cast<int64_t>(offsets[i] + offset), IsFloat(variables[i]));
+    }
+    throw std::out_of_range("Unknown variable '" + name + "'");
+}
+
+ExecutionResult Execute(const ThreeAddressCode& code)
+{
+    ExecutionResult result;
+    Machine machine(code, result);
+    machine.Decode();
+
+    const auto start = std::chrono::steady_clock::now();
+    machine.Run();
+    result.elapsed = std::chrono::steady_clock::now() - start;
+    result.instructions = code.quads.size();
+
+    machine.Finish();
+    return result;
+}
@@ -0,0 +1,68 @@
+#include <stdexcept>
+
+#include <compiler/ir.h>
+
+int64_t ConstantValue(const IrConstant& constant)
+{
+    if (!constant.value)
+        throw std::runtime_error("Integer literal is out of range: '" + constant.text + "'");
+
+    return *constant.value;
+}
+
+std::string OperandName(const ThreeAddressCode& code, const Operand& operand)
+{
+    switch (operand.kind)
+    {
+    case Operand::Kind::Variable:
+        return code.variables[operand.id].name;
+    case Operand::Kind::Temp:
+        return "t" + std::to_string(operand.id);
+    case Operand::Kind::Constant:
+        return code.constants[operand.id].text;
+    case Operand::Kind::None:
+        break;
+    }
+    throw std::logic_error("Operand has no name");
+}
+
+std::string PrintThreeAddressCode(const ThreeAddressCode& code)
+{
+    const auto name = [&code](const Operand& operand)
+    {
+        return OperandName(code, operand);
+    };
+
+    std::string text;
+    for (const auto& quad : code.quads)
+    {
+        switch (quad.op)
+        {
+        case OpCode::Add:
+        case OpCode::Address:
+            text += name(quad.result) + " = " + name(quad.arg1) + " + " + name(quad.arg2);
+            break;
+        case OpCode::Sub:
+            text += name(quad.result) + " = " + name(quad.arg1) + " - " + name(quad.arg2);
+            break;
+        case OpCode::Mul:
+            text += name(quad.result) + " = " + name(quad.arg1) + " * " + name(quad.arg2);
+            break;
+        case OpCode::Div:
+            text += name(quad.result) + " = " + name(quad.arg1) + " / " + name(quad.arg2);
+            break;
+        case OpCode::Copy:
+            text += name(quad.result) + " = " + name(quad.arg1);
+            break;
+        case OpCode::Load:
+            text += name(quad.result) + " = " + name(quad.arg1) + "[" + name(quad.arg2) + "]";
+            break;
+        case OpCode::Store:
+            text += "*" + name(quad.result) + " = " + name(quad.arg1);
+            break;
+        }
+        text += '\n';
+    }
+
+    return text;
+}
@@ -0,0 +1,58 @@
+#include "memory_arena.h"
+
+namespace
+{
+    thread_local std::pmr::memory_resource* currentResource = nullptr;
+}
+
+CountingResource::CountingResource(std::pmr::memory_resource* upstream)
+    : m_upstream(upstream)
+{
+}
+
+void* CountingResource::do_allocate(size_t bytes, size_t alignment)
+{
+    void* p = m_upstream->allocate(bytes, alignment);
+    m_counters.count++;
+    m_counters.bytes += bytes;
+    return p;
+}
+
+void CountingResource::do_deallocate(void* p, size_t bytes, size_t alignment)
+{
+    m_upstream->deallocate(p, bytes, alignment);
+}
+
+bool CountingResource::do_is_equal(const std::pmr::memory_resource& other) const noexcept
+{
+    return this == &other;
+}
+
+std::pmr::memory_resource* CurrentMemoryResource()
+{
+    return currentResource ? currentResource : std::pmr::get_default_resource();
+}
+
+ScopedMemoryResource::ScopedMemoryResource(std::pmr::memory_resource* resource)
+    : m_previous(currentResource)
+{
+    currentResource = resource;
+}
+
+ScopedMemoryResource::~ScopedMemoryResource()
+{
+    currentResource = m_previous;
+}
+
+CompileArena::CompileArena(size_t initialSize)
+    : m_heap(std::pmr::get_default_resource())
+    , m_arena(initialSize, &m_heap)
+    , m_tokenizer(&m_arena)
+    , m_parser(&m_arena)
+{
+}
+
+ArenaStatistics CompileArena::Statistics() const
+{
+    return ArenaStatistics{ m_tokenizer.Counters(), m_parser.Counters(), m_heap.Counters() };
+}
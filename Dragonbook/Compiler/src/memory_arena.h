@@ -0,0 +1,75 @@
+#pragma once
+
+#include <memory_resource>
+
+#include <compiler/compiler.h>
+
+// Memory resource that counts what it passes on to upstream.
+class CountingResource : public std::pmr::memory_resource
+{
+public:
+    explicit CountingResource(std::pmr::memory_resource* upstream);
+
+    const AllocationCounters& Counters() const
+    {
+        return m_counters;
+    }
+
+private:
+    void* do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+    std::pmr::memory_resource* m_upstream;
+    AllocationCounters m_counters;
+};
+
+// Resource the per-compile containers of the tokenizer and the parser
+// allocate from when they are created: the token queue, the parse stack, the
+// code buffers and the index lists of array accesses. It is the default
+// resource unless a ScopedMemoryResource is active on this thread. Containers
+// keep the resource they were created with, so one compile must not mix
+// containers created under different scopes.
+std::pmr::memory_resource* CurrentMemoryResource();
+
+class ScopedMemoryResource
+{
+public:
+    explicit ScopedMemoryResource(std::pmr::memory_resource* resource);
+    ~ScopedMemoryResource();
+
+    ScopedMemoryResource(const ScopedMemoryResource&) = delete;
+    ScopedMemoryResource& operator=(const ScopedMemoryResource&) = delete;
+
+private:
+    std::pmr::memory_resource* m_previous;
+};
+
+// Monotonic arena of one compile, see CompileOptions::useArena. Nothing is
+// freed before the arena is destroyed, which releases all of it at once.
+class CompileArena
+{
+public:
+    explicit CompileArena(size_t initialSize = 64 * 1024);
+
+    CompileArena(const CompileArena&) = delete;
+    CompileArena& operator=(const CompileArena&) = delete;
+
+    std::pmr::memory_resource* Tokenizer()
+    {
+        return &m_tokenizer;
+    }
+
+    std::pmr::memory_resource* Parser()
+    {
+        return &m_parser;
+    }
+
+    ArenaStatistics Statistics() const;
+
+private:
+    CountingResource m_heap;
+    std::pmr::monotonic_buffer_resource m_arena;
+    CountingResource m_tokenizer;
+    CountingResource m_parser;
+};
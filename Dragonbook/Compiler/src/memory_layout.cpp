@@ -0,0 +1,140 @@
+#include <numeric>
+#include <algorithm>
+
+#include <compiler/memory_layout.h>
+
+namespace
+{
+    constexpr size_t TempSize = sizeof(int64_t);
+
+    struct Item
+    {
+        size_t index;
+        size_t size;
+        size_t alignment;
+        bool array;
+        size_t uses;
+    };
+
+    // Operand occurrences of every variable and temporary in the code.
+    void CountUses(const ThreeAddressCode& code, std::vector<size_t>& variables, std::vector<size_t>& temps)
+    {
+        variables.assign(code.variables.size(), 0);
+        temps.assign(code.temps.size(), 0);
+
+        for (const Quad& quad : code.quads)
+        {
+            for (const Operand* operand : { &quad.result, &quad.arg1, &quad.arg2 })
+            {
+                if (operand->kind == Operand::Kind::Variable)
+                    variables[operand->id]++;
+                else if (operand->kind == Operand::Kind::Temp)
+                    temps[operand->id]++;
+            }
+        }
+    }
+
+    MemoryLayout Place(std::vector<Item>& items)
+    {
+        std::stable_sort(items.begin(), items.end(), [](const Item& lhs, const Item& rhs)
+        {
+            if (lhs.array != rhs.array)
+                return !lhs.array;
+            if (lhs.alignment != rhs.alignment)
+                return lhs.alignment > rhs.alignment;
+            return lhs.array ? lhs.size < rhs.size : lhs.uses > rhs.uses;
+        });
+
+        MemoryLayout layout;
+        layout.offsets.resize(items.size());
+
+        for (const Item& item : items)
+        {
+            layout.size = (layout.size + item.alignment - 1) / item.alignment * item.alignment;
+            layout.offsets[item.index] = layout.size;
+            layout.size += item.size;
+        }
+
+        return layout;
+    }
+
+    MemoryLayout LayOutData(const ThreeAddressCode& code, const std::vector<size_t>& uses)
+    {
+        std::vector<Item> items;
+        items.reserve(code.variables.size());
+
+        for (size_t i = 0; i < code.variables.size(); i++)
+        {
+            const IrVariable& variable = code.variables[i];
+            items.push_back(Item{ i, StorageSize(variable), ElementSize(variable), IsArray(variable), uses[i] });
+        }
+
+        return Place(items);
+    }
+}
+
+bool IsArray(const IrVariable& variable)
+{
+    return variable.type.find('[') != std::string::npos;
+}
+
+bool IsFloat(const IrVariable& variable)
+{
+    return variable.type.starts_with("float");
+}
+
+size_t ElementSize(const IrVariable& variable)
+{
+    return IsFloat(variable) ? sizeof(float) : sizeof(int64_t);
+}
+
+size_t StorageSize(const IrVariable& variable)
+{
+    return variable.size == 0 ? sizeof(int64_t) : variable.size;
+}
+
+StorageLayout AllocateStorage(const ThreeAddressCode& code)
+{
+    std::vector<size_t> variableUses;
+    std::vector<size_t> tempUses;
+    CountUses(code, variableUses, tempUses);
+
+    std::vector<Item> temps;
+    temps.reserve(code.temps.size());
+    for (size_t i = 0; i < code.temps.size(); i++)
+        temps.push_back(Item{ i, TempSize, TempSize, false, tempUses[i] });
+
+    return StorageLayout{ LayOutData(code, variableUses), Place(temps) };
+}
+
+MemoryLayout LayOutVariables(const ThreeAddressCode& code)
+{
+    std::vector<size_t> variableUses;
+    std::vector<size_t> tempUses;
+    CountUses(code, variableUses, tempUses);
+
+    return LayOutData(code, variableUses);
+}
+
+std::string PrintStorageLayout(const ThreeAddressCode& code, const StorageLayout& layout)
+{
+    std::string text;
+    const auto print = [&](const MemoryLayout& segment, const char* name, Operand::Kind kind, const auto& sizeOf)
+    {
+        std::vector<size_t> order(segment.offsets.size());
+        std::iota(order.begin(), order.end(), size_t{ 0 });
+        std::sort(order.begin(), order.end(), [&segment](size_t lhs, size_t rhs) { return segment.offsets[lhs] < segment.offsets[rhs]; });
+
+        for (const size_t i : order)
+        {
+            const Operand operand{ kind, static_cast<uint32_t>(i) };
+            text += OperandName(code, operand) + ": " + name + "+" + std::to_string(segment.offsets[i]) + ", " + std::to_string(sizeOf(i)) + " bytes\n";
+        }
+    };
+
+    print(layout.data, "data", Operand::Kind::Variable, [&code](size_t i) { return StorageSize(code.variables[i]); });
+    print(layout.frame, "frame", Operand::Kind::Temp, [](size_t) { return TempSize; });
+
+    text += "footprint: " + std::to_string(layout.Footprint()) + " bytes\n";
+    return text;
+}
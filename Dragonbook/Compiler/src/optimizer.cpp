@@ -0,0 +1,386 @@
+#include <map>
+#include <tuple>
+#include <string>
+#include <limits>
+#include <vector>
+#include <optional>
+#include <unordered_map>
+
+#include <compiler/optimizer.h>
+
+namespace
+{
+    using ValueNumber = uint32_t;
+
+    struct ExpressionKey
+    {
+        OpCode op;
+        ValueNumber lhs;
+        ValueNumber rhs;
+
+        bool operator <(const ExpressionKey& other) const
+        {
+            return std::tie(op, lhs, rhs) < std::tie(other.op, other.lhs, other.rhs);
+        }
+    };
+
+    struct AvailableValue
+    {
+        ValueNumber number;
+        Operand holder;
+        // Array read by a Load, so that stores into it can kill the value.
+        std::optional<uint32_t> loadedArray;
+    };
+
+    class ValueNumbering
+    {
+    public:
+        explicit ValueNumbering(const ThreeAddressCode& code)
+            : m_code(code)
+            , m_variables(code.variables.size())
+            , m_temps(code.temps.size())
+        {
+        }
+
+        ValueNumber Of(const Operand& operand)
+        {
+            switch (operand.kind)
+            {
+            case Operand::Kind::Variable:
+                return Slot(m_variables[operand.id]);
+            case Operand::Kind::Temp:
+                return Slot(m_temps[operand.id]);
+            case Operand::Kind::Constant:
+            {
+                // Literals too large for 64 bits are told apart by their text.
+                const IrConstant& constant = m_code.constants[operand.id];
+                const auto [number, inserted] = constant.value
+                    ? Number(m_constants.try_emplace(*constant.value, m_next))
+                    : Number(m_literals.try_emplace(constant.text, m_next));
+                if (inserted)
+                    m_next++;
+                return number;
+            }
+            case Operand::Kind::None:
+                break;
+            }
+            return Fresh();
+        }
+
+        void Assign(const Operand& operand, ValueNumber number)
+        {
+            if (operand.kind == Operand::Kind::Variable)
+                m_variables[operand.id] = number;
+            else if (operand.kind == Operand::Kind::Temp)
+                m_temps[operand.id] = number;
+        }
+
+        ValueNumber Fresh()
+        {
+            return m_next++;
+        }
+
+    private:
+        ValueNumber Slot(std::optional<ValueNumber>& slot)
+        {
+            if (!slot)
+                slot = Fresh();
+            return *slot;
+        }
+
+        template<typename Emplaced>
+        static std::pair<ValueNumber, bool> Number(const Emplaced& emplaced)
+        {
+            return { emplaced.first->second, emplaced.second };
+        }
+
+        const ThreeAddressCode& m_code;
+        std::vector<std::optional<ValueNumber>> m_variables;
+        std::vector<std::optional<ValueNumber>> m_temps;
+        std::unordered_map<int64_t, ValueNumber> m_constants;
+        std::unordered_map<std::string, ValueNumber> m_literals;
+        ValueNumber m_next{ 0 };
+    };
+
+    bool IsCommutative(OpCode op)
+    {
+        return op == OpCode::Add || op == OpCode::Mul;
+    }
+
+    // Operands read by a quad. The address of a Store is read, not written.
+    template<typename Quad, typename F>
+    void ForEachUse(Quad& quad, F&& f)
+    {
+        if (quad.op == OpCode::Store)
+            f(quad.result);
+        if (quad.arg1.kind != Operand::Kind::None)
+            f(quad.arg1);
+        if (quad.arg2.kind != Operand::Kind::None)
+            f(quad.arg2);
+    }
+
+    bool Defines(const Quad& quad, const Operand& operand)
+    {
+        return quad.op != OpCode::Store && quad.result == operand;
+    }
+
+    bool Uses(const Quad& quad, const Operand& operand)
+    {
+        bool used = false;
+        ForEachUse(quad, [&](const Operand& use) { used = used || use == operand; });
+        return used;
+    }
+
+    // Rewrites t = expr; ... x = t into x = expr when the copy is the only use
+    // of t and x is neither read nor written in between.
+    size_t CoalesceCopies(ThreeAddressCode& code)
+    {
+        constexpr size_t none = std::numeric_limits<size_t>::max();
+        std::vector<size_t> definition(code.temps.size(), none);
+        std::vector<uint32_t> uses(code.temps.size(), 0);
+
+        for (size_t i = 0; i < code.quads.size(); i++)
+        {
+            const Quad& quad = code.quads[i];
+            ForEachUse(quad, [&uses](const Operand& use)
+            {
+                if (use.kind == Operand::Kind::Temp)
+                    uses[use.id]++;
+            });
+
+            if (quad.op != OpCode::Store && quad.result.kind == Operand::Kind::Temp)
+                definition[quad.result.id] = i;
+        }
+
+        std::vector<bool> removed(code.quads.size(), false);
+        size_t count = 0;
+        for (size_t i = 0; i < code.quads.size(); i++)
+        {
+            const Quad& copy = code.quads[i];
+            if (copy.op != OpCode::Copy || copy.result.kind != Operand::Kind::Variable || copy.arg1.kind != Operand::Kind::Temp)
+                continue;
+
+            const size_t d = definition[copy.arg1.id];
+            if (uses[copy.arg1.id] != 1 || d == none || d > i)
+                continue;
+
+            bool clobbered = false;
+            for (size_t j = d + 1; j < i && !clobbered; j++)
+                clobbered = !removed[j] && (Defines(code.quads[j], copy.result) || Uses(code.quads[j], copy.result));
+
+            if (clobbered)
+                continue;
+
+            code.quads[d].result = copy.result;
+            removed[i] = true;
+            count++;
+        }
+
+        std::erase_if(code.quads, [&removed, i = size_t{ 0 }](const Quad&) mutable { return removed[i++]; });
+        return count;
+    }
+}
+
+size_t EliminateCommonSubexpressions(ThreeAddressCode& code)
+{
+    ValueNumbering numbers(code);
+    std::map<ExpressionKey, AvailableValue> available;
+
+    // Temporaries whose computation was removed, and what replaces them.
+    std::vector<std::optional<Operand>> replaced(code.temps.size());
+    // Array each address temporary points into.
+    std::vector<std::optional<uint32_t>> addressedArray(code.temps.size());
+
+    const auto substitute = [&replaced](Operand& operand)
+    {
+        if (operand.kind == Operand::Kind::Temp && replaced[operand.id])
+            operand = *replaced[operand.id];
+    };
+
+    std::vector<Quad> quads;
+    quads.reserve(code.quads.size());
+
+    for (Quad quad : code.quads)
+    {
+        substitute(quad.arg1);
+        substitute(quad.arg2);
+
+        switch (quad.op)
+        {
+        case OpCode::Copy:
+            numbers.Assign(quad.result, numbers.Of(quad.arg1));
+            quads.push_back(quad);
+            break;
+
+        case OpCode::Store:
+        {
+            substitute(quad.result);
+
+            const auto& array = (quad.result.kind == Operand::Kind::Temp) ? addressedArray[quad.result.id] : std::nullopt;
+            for (auto it = available.begin(); it != available.end();)
+            {
+                const auto& loaded = it->second.loadedArray;
+                if (loaded && (!array || *loaded == *array))
+                    it = available.erase(it);
+                else
+                    ++it;
+            }
+            quads.push_back(quad);
+            break;
+        }
+
+        default:
+        {
+            ExpressionKey key{ quad.op, numbers.Of(quad.arg1), numbers.Of(quad.arg2) };
+            if (IsCommutative(quad.op) && key.rhs < key.lhs)
+                std::swap(key.lhs, key.rhs);
+
+            const auto it = available.find(key);
+            if (it != available.end() && numbers.Of(it->second.holder) == it->second.number)
+            {
+                const Operand& holder = it->second.holder;
+                if (quad.result.kind == Operand::Kind::Temp)
+                {
+                    replaced[quad.result.id] = holder;
+                }
+                else
+                {
+                    numbers.Assign(quad.result, it->second.number);
+                    quads.push_back(Quad{ OpCode::Copy, quad.result, holder });
+                }
+                break;
+            }
+
+            const ValueNumber number = numbers.Fresh();
+            numbers.Assign(quad.result, number);
+
+            std::optional<uint32_t> loadedArray;
+            if (quad.op == OpCode::Load && quad.arg1.kind == Operand::Kind::Variable)
+                loadedArray = quad.arg1.id;
+
+            if (quad.op == OpCode::Address && quad.result.kind == Operand::Kind::Temp && quad.arg1.kind == Operand::Kind::Variable)
+                addressedArray[quad.result.id] = quad.arg1.id;
+
+            available[key] = AvailableValue{ number, quad.result, loadedArray };
+            quads.push_back(quad);
+            break;
+        }
+        }
+    }
+
+    const size_t removed = code.quads.size() - quads.size();
+    code.quads = std::move(quads);
+    return removed;
+}
+
+size_t PropagateCopies(ThreeAddressCode& code)
+{
+    const size_t removed = CoalesceCopies(code);
+
+    struct Copy
+    {
+        Operand source;
+        // Version of the source variable at the copy.
+        uint32_t sourceVersion{ 0 };
+    };
+
+    std::vector<uint32_t> version(code.variables.size(), 0);
+    std::vector<std::optional<Copy>> copies(code.variables.size());
+
+    for (Quad& quad : code.quads)
+    {
+        ForEachUse(quad, [&](Operand& use)
+        {
+            if (use.kind != Operand::Kind::Variable || !copies[use.id])
+                return;
+
+            const Copy& copy = *copies[use.id];
+            if (copy.source.kind != Operand::Kind::Variable || version[copy.source.id] == copy.sourceVersion)
+                use = copy.source;
+        });
+
+        if (quad.op == OpCode::Store || quad.result.kind != Operand::Kind::Variable)
+            continue;
+
+        const uint32_t v = quad.result.id;
+        version[v]++;
+        copies[v].reset();
+
+        if (quad.op == OpCode::Copy && quad.arg1 != quad.result)
+        {
+            const uint32_t sourceVersion = (quad.arg1.kind == Operand::Kind::Variable) ? version[quad.arg1.id] : 0;
+            copies[v] = Copy{ quad.arg1, sourceVersion };
+        }
+    }
+
+    return removed;
+}
+
+size_t EliminateDeadCode(ThreeAddressCode& code)
+{
+    // Every variable is live at the end of the program.
+    std::vector<bool> liveVariables(code.variables.size(), true);
+    std::vector<bool> liveTemps(code.temps.size(), false);
+
+    const auto live = [&](const Operand& operand) -> std::vector<bool>::reference
+    {
+        return (operand.kind == Operand::Kind::Variable) ? liveVariables[operand.id] : liveTemps[operand.id];
+    };
+
+    std::vector<Quad> quads;
+    quads.reserve(code.quads.size());
+
+    for (auto it = code.quads.rbegin(); it != code.quads.rend(); ++it)
+    {
+        const Quad& quad = *it;
+        if (quad.op != OpCode::Store)
+        {
+            if (!live(quad.result))
+                continue;
+            live(quad.result) = false;
+        }
+
+        ForEachUse(quad, [&](const Operand& use)
+        {
+            if (use.kind == Operand::Kind::Variable || use.kind == Operand::Kind::Temp)
+                live(use) = true;
+        });
+        quads.push_back(quad);
+    }
+
+    const size_t removed = code.quads.size() - quads.size();
+    code.quads.assign(quads.rbegin(), quads.rend());
+
+    // Drop the temporaries nothing refers to any more.
+    std::vector<bool> used(code.temps.size(), false);
+    for (const Quad& quad : code.quads)
+    {
+        for (const Operand* operand : { &quad.result, &quad.arg1, &quad.arg2 })
+        {
+            if (operand->kind == Operand::Kind::Temp)
+                used[operand->id] = true;
+        }
+    }
+
+    std::vector<uint32_t> renumbered(code.temps.size(), 0);
+    std::vector<IrTemp> temps;
+    for (size_t i = 0; i < code.temps.size(); i++)
+    {
+        if (!used[i])
+            continue;
+        renumbered[i] = static_cast<uint32_t>(temps.size());
+        temps.push_back(std::move(code.temps[i]));
+    }
+    code.temps = std::move(temps);
+
+    for (Quad& quad : code.quads)
+    {
+        for (Operand* operand : { &quad.result, &quad.arg1, &quad.arg2 })
+        {
+            if (operand->kind == Operand::Kind::Temp)
+                operand->id = renumbered[operand->id];
+        }
+    }
+
+    return removed;
+}
@@ -1,356 +1,113 @@
-#include <map>
-#include <deque>
 #include <queue>
-#include <stack>
-#include <variant>
-#include <boost/lexical_cast.hpp>
+#include <vector>
+#include <algorithm>
 
 #include "grammar_reader.h"
 #include "parser.h"
+#include "grammar_tables.h"
 
-using Type = std::pair<std::string, size_t>;
-using SymbolTable = std::map<std::string, Type>;
+template<typename Table, typename Statistics>
+LrAnalyzer<Table, Statistics>::LrAnalyzer(const Table& table, const SemanticActions& actions, TokenQueue&& input, const CompileOptions& options, SymbolTable symbols)
+    : m_t(table)
+    , m_actions(actions)
+    , m_input(std::move(input))
+    , m_states(CurrentMemoryResource())
+    , m_attributes(CurrentMemoryResource())
+{
+    m_translation.options = options;
+    m_translation.symbols = std::move(symbols);
+    m_states.reserve(64);
+    m_attributes.reserve(64);
 
-using AnnotatedState = std::pair<State, Annotation>;
+    m_states.push_back(0);
+    m_attributes.emplace_back();
+    m_input.push(Token{});
+}
 
-static size_t GetSizeOf(const std::string& basicType)
+template<typename Table, typename Statistics>
+LrAnalyzer<Table, Statistics>::LrAnalyzer(const Table& table, const SemanticActions& actions, TokenSource&& source, const CompileOptions& options, StatementSink&& sink)
+    : m_t(table)
+    , m_actions(actions)
+    , m_source(std::move(source))
+    , m_states(CurrentMemoryResource())
+    , m_attributes(CurrentMemoryResource())
 {
-    if (basicType == "int")
-        return 8;
-    else if (basicType == "float")
-        return 4;
-    else
-        throw std::invalid_argument("");
+    m_translation.options = options;
+    m_translation.sink = std::move(sink);
+    m_states.reserve(64);
+    m_attributes.reserve(64);
+
+    m_states.push_back(0);
+    m_attributes.emplace_back();
 }
 
-void ReduceHandler(const Reduce& reduce, std::vector<AnnotatedState>&& oldStates, SymbolTable& symbols, AnnotatedState& newState, size_t& tempVarsCounter)
+template<typename Table, typename Statistics>
+Token& LrAnalyzer<Table, Statistics>::Lookahead()
 {
-    const auto generateTempVar = [&tempVarsCounter]()
-    {
-        return "t" + std::to_string(tempVarsCounter++);
-    };
-
-    const auto binaryOp = [&](const std::string& opName)
+    if (m_input.empty())
     {
-        const Code lhsCode = oldStates[0].second.code;
-        const Code rhsCode = oldStates[2].second.code;
-
-        const std::string temp = generateTempVar();
-        symbols.insert({ temp, { "int", 8 } });
-
-        newState.second.code.result = temp;
-        newState.second.code.lines = lhsCode.lines + rhsCode.lines
-            + temp + " = " + lhsCode.result + " " + opName + " " + rhsCode.result + "\n";
-    };
+        // The end of input is the empty token, like the one pushed after a
+        // complete input.
+        std::optional<Token> token = m_source ? m_source() : std::nullopt;
+        if (!token)
+            m_source = nullptr;
+        m_input.push(token ? std::move(*token) : Token{});
+    }
+    return m_input.front();
+}
 
-    const auto parseArray = [&symbols, &generateTempVar](const Array& arr, bool rValue)
+template<typename Table, typename Statistics>
+ThreeAddressCode LrAnalyzer<Table, Statistics>::Analyze()
+{
+    while (true)
     {
-        std::string arrTypeName = arr.name;
-        std::string newCode;
-        std::queue<std::string> vars;
+        const auto terminal = m_t.FindTerminal(Lookahead().first);
+        if (!terminal)
+            throw std::runtime_error("Syntax error. State: " + std::to_string(m_states.back()) + ". Current token: " + Lookahead().first);
 
-        std::deque<std::string> indexes = arr.indexes;
-        std::reverse(indexes.begin(), indexes.end());
-        
-        for (auto it = indexes.rbegin(); it != indexes.rend(); ++it)
+        const Action& action = m_t.At(m_states.back(), *terminal);
+        switch (action.type)
         {
-            arrTypeName += "[]";
-            const auto symbol = symbols.find(arrTypeName);
-            if (symbol == symbols.end())
-                throw std::runtime_error("Undefined symbol '" + arrTypeName + "'");
-
-            const auto varSize = symbols.at(arrTypeName).second;
-
-            const std::string offset = generateTempVar();
-            symbols.insert({ offset, { "size_t", 64 } });
-
-            newCode += (offset + " = " + *it + " * " + std::to_string(varSize) + "\n");
-            vars.push(offset);
-        }
-
-        std::string newResult;
-        if (vars.size() > 1)
+        case Action::Type::Shift:
         {
-            const std::string temp = generateTempVar();
-            const auto t1 = vars.front();
-            vars.pop();
-            const auto t2 = vars.front();
-            vars.pop();
-
-            symbols.insert({ t1, { "size_t", 64 } });
-            symbols.insert({ t2, { "size_t", 64 } });
-
-            newCode += (temp + " = " + t1 + " + " + t2 + "\n");
-            newResult = temp;
-
-            while (!vars.empty())
-            {
-                const std::string nextTemp = generateTempVar();
-                symbols.insert({ nextTemp, { "size_t", 64 } });
-
-                newCode += (nextTemp + " = " + newResult + " + " + vars.front() + "\n");
-                vars.pop();
-                newResult = nextTemp;
-            }
+            m_states.push_back(action.value);
+            m_attributes.emplace_back(std::move(Lookahead()));
+            m_input.pop();
+            m_statistics.Shift(m_states.size());
+            break;
         }
-        else
+        case Action::Type::Reduce:
         {
-            newResult = vars.front();
+            const size_t production = action.value;
+            const size_t length = m_t.ProductionRhs(production).size();
+            const size_t rhsStart = m_attributes.size() - length;
+
+            const State top = m_states[m_states.size() - 1 - length];
+            const SymbolId lhs = m_t.ProductionLhs(production);
+            const Action& gotoAction = m_t.At(top, lhs);
+            if (gotoAction.type != Action::Type::Shift)
+                throw std::runtime_error("Syntax error. State: " + std::to_string(top) + ". Current non terminal: " + std::string(m_t.SymbolName(lhs)));
+
+            Annotation result;
+            m_actions.Reduce(production, m_translation, std::span<Annotation>{ m_attributes }.subspan(rhsStart), result);
+
+            m_states.resize(m_states.size() - length);
+            m_attributes.resize(rhsStart);
+
+            m_states.push_back(gotoAction.value);
+            m_attributes.push_back(std::move(result));
+            m_statistics.Reduce(production, m_states.size());
+            break;
         }
-
-        const std::string temp = generateTempVar();
-        symbols.insert({ temp, symbols.at(arrTypeName) });
-
-        if (rValue)
-        {
-            return std::pair<std::string, std::string>{ temp, arr.lines + newCode
-                + temp + " = " + arr.name + "[" + newResult + "]\n" };
+        case Action::Type::Accept:
+            return FinishTranslation(std::move(m_translation), std::move(m_attributes.back()));
+        case Action::Type::Error:
+            throw std::runtime_error("Syntax error. State: " + std::to_string(m_states.back()) + ". Current token: " + Lookahead().first);
         }
-        else
-        {
-            return std::pair<std::string, std::string>{ temp, arr.lines + newCode
-                + temp + " = " + arr.name + " + " + newResult + "\n" };
-        }
-    };
-
-    // G' -> G
-    if (reduce.to == std::vector<GrammarSymbol>{ { true, "G" } })
-    {
-        newState.second.code = oldStates[0].second.code;
-    }
-    // G -> G Declarations Assign
-    else if (reduce.to == std::vector<GrammarSymbol>{ { true, "G" }, { true, "Declarations" }, { true, "Assign" } })
-    {
-        const Code gCode  = oldStates[0].second.code;
-        const Code declCode = oldStates[1].second.code;
-        const Code assignCode  = oldStates[2].second.code;
-
-        newState.second.code.lines = gCode.lines + declCode.lines + assignCode.lines;
-    }
-    // G -> 
-    // Assign -> id = Expr ;
-    else if (reduce.to == std::vector<GrammarSymbol>{ { false, "id" }, { false, "=" }, { true, "Expr" }, { false, ";" } })
-    {
-        const auto varName = oldStates[0].second.token.second;
-        const Code oldCode = oldStates[2].second.code;
-
-        newState.second.code.result = varName;
-        newState.second.code.lines = oldCode.lines
-            + varName + " = " + oldCode.result + "\n";
-    }
-    // Assign -> Array = Expr ;
-    else if (reduce.to == std::vector<GrammarSymbol>{ { true, "Array" }, { false, "=" }, { true, "Expr" }, { false, ";" } })
-    {
-        const auto arr = parseArray(oldStates[0].second.arr, false);
-
-        const Code oldCode = oldStates[2].second.code;
-
-        newState.second.code.result = "*" + arr.first;
-        newState.second.code.lines = oldCode.lines + arr.second
-            + "*" + arr.first + " = " + oldCode.result + "\n";
-    }
-    // Assign ->
-    // Expr -> Expr * Expr
-    else if (reduce.to == std::vector<GrammarSymbol>{ { true, "Expr" }, { false, "*" }, { true, "Expr" } })
-    {
-        binaryOp("*");
-    }
-    // Expr -> Expr / Expr
-    else if (reduce.to == std::vector<GrammarSymbol>{ { true, "Expr" }, { false, "/" }, { true, "Expr" } })
-    {
-        binaryOp("/");
-    }
-    // Expr -> Expr + Expr
-    else if (reduce.to == std::vector<GrammarSymbol>{ { true, "Expr" }, { false, "+" }, { true, "Expr" } })
-    {
-        binaryOp("+");
-    }
-    // Expr -> Expr - Expr
-    else if (reduce.to == std::vector<GrammarSymbol>{ { true, "Expr" }, { false, "-" }, { true, "Expr" } })
-    {
-        binaryOp("-");
-    }
-    // Expr -> - Expr
-    else if (reduce.to == std::vector<GrammarSymbol>{ { false, "-" }, { true, "Expr" } })
-    {
-        const Code oldCode = oldStates[1].second.code;
-
-        const std::string temp = generateTempVar();
-        symbols.insert({ temp, { "int", 8 } });
-        newState.second.code.lines = oldCode.lines + temp + " = 0 - " + oldCode.result + "\n";
-        newState.second.code.result = temp;
-    }
-    // Expr -> ( Expr )
-    else if (reduce.to == std::vector<GrammarSymbol>{ { false, "(" }, { true, "Expr" } , { false, ")" } })
-    {
-        newState.second.code = oldStates[1].second.code;
     }
-    // Expr -> id
-    else if (reduce.to == std::vector<GrammarSymbol>{ { false, "id" } })
-    {
-        const auto varName = oldStates[0].second.token.second;
-        if (symbols.find(varName) == symbols.end())
-            throw std::runtime_error("Undefined symbol '" + varName + "'");
-
-        newState.second.code.result = varName;
-    }
-    // Expr -> Array
-    else if (reduce.to == std::vector<GrammarSymbol>{ { true, "Array" } })
-    {
-        const auto res = parseArray(oldStates[0].second.arr, true);
-        newState.second.code.result = res.first;
-        newState.second.code.lines = res.second;
-    }
-    // Expr -> num
-    else if (reduce.to == std::vector<GrammarSymbol>{ { false, "num" } })
-    {
-        newState.second.code.result = oldStates[0].second.token.second;
-    }
-    // Array -> id [ Expr ]
-    else if (reduce.to == std::vector<GrammarSymbol>{ { false, "id" }, { false, "[" }, { true, "Expr" }, { false, "]" } })
-    {
-        const Code oldCode = oldStates[2].second.code;
-        const auto varName = oldStates[0].second.token.second;
-
-        newState.second.arr.name = varName;
-        newState.second.arr.lines = oldCode.lines;
-        newState.second.arr.indexes.push_back(oldCode.result);
-    }
-    // Array -> Array [ Expr ]
-    else if (reduce.to == std::vector<GrammarSymbol>{ { true, "Array" }, { false, "[" }, { true, "Expr" }, { false, "]" } })
-    {
-        const Code oldCode = oldStates[2].second.code;
-        const auto arr = oldStates[0].second.arr;
-
-        newState.second.arr.name = arr.name;
-        newState.second.arr.lines = arr.lines + oldCode.lines;
-        newState.second.arr.indexes = arr.indexes;
-        newState.second.arr.indexes.push_back(oldCode.result);
-    }
-    // Declarations -> Declaration ; Declarations
-    else if (reduce.to == std::vector<GrammarSymbol>{ { true, "Declaration" }, { false, ";" }, { true, "Declarations" } })
-    {
-        newState.second.code.lines = oldStates[2].second.code.lines;
-    }
-    // Declarations -> Declaration = Expr ; Declarations
-    else if (reduce.to == std::vector<GrammarSymbol>{ { true, "Declaration" }, { false, "=" }, { true, "Expr" }, { false, ";" }, { true, "Declarations" } })
-    {
-        const auto varName = oldStates[0].second.arr.name;
-        const Code oldCode = oldStates[2].second.code;
-
-        newState.second.code.result = varName;
-        newState.second.code.lines = oldCode.lines
-            + varName + " = " + oldCode.result + "\n"
-            + oldStates[4].second.code.lines;
-    }
-    // Declarations ->
-    // Declaration -> BasicType IndexesOptional id
-    else if (reduce.to == std::vector<GrammarSymbol>{ { true, "BasicType" }, { true, "IndexesOptional" }, { false, "id" } })
-    {
-        auto varName = oldStates[2].second.token.second;
-        Array type = oldStates[1].second.arr;
-
-        for (size_t i = 0; i < type.indexes.size(); ++i)
-            varName += "[]";
-
-        auto typeName = oldStates[0].second.arr.name;
-        auto size = GetSizeOf(typeName);
-
-        symbols.try_emplace(varName, typeName, size);
-
-        for (auto it = type.indexes.rbegin(); it != type.indexes.rend(); ++it)
-        {
-            size *= boost::lexical_cast<size_t>(*it);
-            varName.pop_back(); // pop ]
-            varName.pop_back(); // pop [
-            typeName += "[]";
-
-            symbols.try_emplace(varName, typeName, size);
-        }
-
-        newState.second.arr.name = varName;
-    }
-    // BasicType -> int
-    else if (reduce.to == std::vector<GrammarSymbol>{ { false, "int" } })
-    {
-        newState.second.arr.name = "int";
-    }
-    // BasicType -> float
-    else if (reduce.to == std::vector<GrammarSymbol>{ { false, "float" } })
-    {
-        newState.second.arr.name = "float";
-    }
-    /// IndexesOptional ->[ num ] IndexesOptional
-    else if (reduce.to == std::vector<GrammarSymbol>{ { false, "[" }, { false, "num" }, { false, "]" }, { true, "IndexesOptional" } })
-    {
-        auto indexes = oldStates[3].second.arr.indexes;
-        indexes.push_front(oldStates[1].second.token.second);
-        newState.second.arr.indexes = indexes;
-    }
-    // IndexesOptional ->
-}
-
-LrAnalyzer::LrAnalyzer(const LalrTable& table, const std::queue<Token>& input)
-    : m_t(table)
-    , m_input(input)
-    , m_tempVarsCounter(0)
-{
-    m_states.push({ 0, Annotation{} });
-    m_input.push(Token{});
 }
 
-Annotation LrAnalyzer::Analyze()
-{
-    while (true)
-    {
-        const GrammarSymbol elem{ false, m_input.front().first };
-        const auto it = m_t.find({ m_states.top().first, elem });
-
-        if (it == m_t.end())
-            throw std::runtime_error("Syntax error. State: " + std::to_string(m_states.top().first) + ". Current token: " + m_input.front().first);
-
-        bool accepted = false;
-        std::visit(
-            [this, &accepted](auto& arg)
-            {
-                using T = std::decay_t<decltype(arg)>;
-
-                if constexpr (std::is_same_v<T, Shift>) 
-                {
-                    m_states.push({ arg.st, Annotation{ m_input.front() } });
-                    m_input.pop();
-                }
-                else if constexpr (std::is_same_v<T, Reduce>)
-                {
-                    std::vector<AnnotatedState> states;
-                    for (const auto& i : arg.to)
-                    {
-                        states.push_back(m_states.top());
-                        m_states.pop();
-                    }
-                    std::reverse(states.begin(), states.end());
-
-                    const auto gotoIt = m_t.find({ m_states.top().first, GrammarSymbol{ true, arg.from.nonTerm } });
-                    if (gotoIt == m_t.end())
-                        throw std::runtime_error("Syntax error. State: " + std::to_string(m_states.top().first) + ". Current non terminal: " + arg.from.nonTerm);
-
-                    const auto shift = std::get<Shift>(gotoIt->second);
-                    m_states.push({ shift.st, Annotation{} });
-                    ReduceHandler(arg, std::move(states), m_symbols, m_states.top(), m_tempVarsCounter);
-                }
-                else if constexpr (std::is_same_v<T, Accept>)
-                {
-                    accepted = true;
-                }
-                else
-                {
-                    throw std::logic_error("visitor error");
-                }
-            }, it->second);
-
-        if (accepted)
-        {
-            return m_states.top().second;
-        }
-    }
-}
+template class LrAnalyzer<LalrTable>;
+template class LrAnalyzer<BuiltinGrammar>;
+template class LrAnalyzer<LalrTable, ParserStatistics>;
+template class LrAnalyzer<BuiltinGrammar, ParserStatistics>;
@@ -1,55 +1,85 @@
 #pragma once
 #include <queue>
-#include <stack>
+#include <vector>
+#include <algorithm>
+#include <optional>
+#include <functional>
 
 #include "grammar_reader.h"
+#include "semantic_actions.h"
+#include "tokenizer.h"
 
-using Type = std::pair<std::string, size_t>;
-using SymbolTable = std::map<std::string, Type>;
-
-using Token = std::pair<std::string, std::string>;
-
-struct Code
+// Statistics policies of LrAnalyzer. The default one does nothing and takes
+// no space, so an analyzer without statistics compiles to the same code as
+// one that never counted anything.
+struct NoParserStatistics
 {
-    std::string result;
-    std::string lines;
+    void Shift(size_t) {}
+    void Reduce(size_t, size_t) {}
 };
 
-struct Array
+struct ParserStatistics
 {
-    std::string name;
-    std::deque<std::string> indexes;
-    std::string lines;
-};
+    size_t shifts{ 0 };
+    // Number of reductions by every production, indexed by production.
+    std::vector<size_t> reductions;
+    // Largest number of states on the parse stack.
+    size_t stackHighWater{ 0 };
 
-struct Annotation
-{
-    Annotation() {}
-    Annotation(const Token& t)
+    void Shift(size_t depth)
     {
-        token = t;
-        isToken = true;
+        shifts++;
+        stackHighWater = std::max(stackHighWater, depth);
     }
 
-    bool isToken{ false };
-
-    Array arr;
-    Code code;
-    Token token;
+    // depth is that of the stack after the GOTO state is pushed, which
+    // exceeds the one before the reduction for empty productions.
+    void Reduce(size_t production, size_t depth)
+    {
+        if (reductions.size() <= production)
+            reductions.resize(production + 1, 0);
+        reductions[production]++;
+        stackHighWater = std::max(stackHighWater, depth);
+    }
 };
 
-using AnnotatedState = std::pair<State, Annotation>;
-
+// Table is either LalrTable, loaded at runtime, or a StaticLalrTable
+// generated at build time. Statistics is one of the policies above.
+template<typename Table, typename Statistics = NoParserStatistics>
 class LrAnalyzer
 {
 public:
-    LrAnalyzer(const LalrTable& table, const std::queue<Token>& input);
-    Annotation Analyze();
+    // The table and the actions are referenced, not copied, and must outlive
+    // the analyzer. symbols are the declarations already in scope.
+    LrAnalyzer(const Table& table, const SemanticActions& actions, TokenQueue&& input, const CompileOptions& options = {}, SymbolTable symbols = {});
+
+    // Pulls the tokens from source one at a time, until it returns nothing.
+    // The code of every top-level statement goes to sink as soon as it is
+    // reduced, see TranslationState::sink.
+    using TokenSource = std::function<std::optional<Token>()>;
+    LrAnalyzer(const Table& table, const SemanticActions& actions, TokenSource&& source, const CompileOptions& options, StatementSink&& sink);
+
+    ThreeAddressCode Analyze();
+
+    const Statistics& GetStatistics() const
+    {
+        return m_statistics;
+    }
 
 private:
-    LalrTable m_t;
-    std::queue<Token> m_input;
-    std::stack<AnnotatedState> m_states;
-    SymbolTable m_symbols;
-    size_t m_tempVarsCounter;
+    Token& Lookahead();
+
+    const Table& m_t;
+    const SemanticActions& m_actions;
+    TokenQueue m_input;
+    TokenSource m_source;
+
+    // The parse stack is kept as two parallel arrays, so that the attributes
+    // of a right-hand side are contiguous and handed to the semantic action
+    // as a span. Their capacity is reused for the whole compile. Like the
+    // rest of the per-compile state, they allocate from CurrentMemoryResource.
+    std::pmr::vector<State> m_states;
+    std::pmr::vector<Annotation> m_attributes;
+    TranslationState m_translation;
+    [[no_unique_address]] Statistics m_statistics;
 };
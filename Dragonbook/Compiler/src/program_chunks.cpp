@@ -0,0 +1,140 @@
+#include <string>
+#include <algorithm>
+
+#include "program_chunks.h"
+
+void CollectDeclaration(SymbolTable& symbols, const std::vector<Token>& statement)
+{
+    // Declaration -> BasicType IndexesOptional id, followed by ; or =
+    if (statement.empty() || (statement[0].first != "int" && statement[0].first != "float"))
+        return;
+
+    std::vector<std::string> dimensions;
+    size_t i = 1;
+    while (i + 2 < statement.size() && statement[i].first == "[" && statement[i + 1].first == "num" && statement[i + 2].first == "]")
+    {
+        dimensions.push_back(statement[i + 1].second);
+        i += 3;
+    }
+
+    if (i < statement.size() && statement[i].first == "id")
+        DeclareSymbol(symbols, statement[0].first, statement[i].second, dimensions);
+}
+
+std::vector<ProgramChunk> SplitProgram(TokenQueue&& tokens, size_t count)
+{
+    const size_t target = std::max<size_t>(tokens.size() / std::max<size_t>(count, 1), 1);
+
+    std::vector<ProgramChunk> chunks(1);
+    SymbolTable symbols;
+    std::vector<Token> statement;
+    // Number of the last chunk that used each name, 0 for none.
+    std::vector<size_t> usedBy;
+
+    while (!tokens.empty())
+    {
+        statement.push_back(std::move(tokens.front()));
+        tokens.pop();
+
+        if (statement.back().first != ";" && !tokens.empty())
+            continue;
+
+        // A name first used by this statement has not been declared yet in
+        // this chunk, so its declaration so far is the one in scope when the
+        // chunk starts.
+        for (const Token& token : statement)
+        {
+            if (token.first != "id")
+                continue;
+
+            const NameId name = symbols.Intern(token.second);
+            usedBy.resize(symbols.Size(), 0);
+            if (usedBy[name] == chunks.size())
+                continue;
+
+            usedBy[name] = chunks.size();
+            if (const TypeDescriptor* type = symbols.TypeOf(name))
+                chunks.back().symbols.Declare(token.second, *type);
+        }
+
+        CollectDeclaration(symbols, statement);
+        const bool assignment = statement.front().first == "id";
+
+        auto& chunk = chunks.back().tokens;
+        for (auto& token : statement)
+            chunk.push(std::move(token));
+        statement.clear();
+
+        if (assignment && chunk.size() >= target && chunks.size() < count && !tokens.empty())
+            chunks.emplace_back();
+    }
+
+    return chunks;
+}
+
+void ChunkMerger::Append(const ThreeAddressCode& chunk)
+{
+    std::vector<uint32_t> variables;
+    variables.reserve(chunk.variables.size());
+    for (const IrVariable& variable : chunk.variables)
+    {
+        const auto [it, inserted] = m_variableIds.try_emplace(variable.name, static_cast<uint32_t>(m_program.variables.size()));
+        if (inserted)
+            m_program.variables.push_back(variable);
+        else if (m_program.variables[it->second].type.empty())
+            m_program.variables[it->second] = variable;
+        variables.push_back(it->second);
+    }
+
+    std::vector<uint32_t> constants;
+    constants.reserve(chunk.constants.size());
+    for (const IrConstant& constant : chunk.constants)
+    {
+        const auto [it, inserted] = m_constantIds.try_emplace(constant.text, static_cast<uint32_t>(m_program.constants.size()));
+        if (inserted)
+            m_program.constants.push_back(constant);
+        constants.push_back(it->second);
+    }
+
+    const auto tempOffset = static_cast<uint32_t>(m_program.temps.size());
+    m_program.temps.insert(m_program.temps.end(), chunk.temps.begin(), chunk.temps.end());
+
+    m_program.quads.reserve(m_program.quads.size() + chunk.quads.size());
+    for (Quad quad : chunk.quads)
+    {
+        for (Operand* operand : { &quad.result, &quad.arg1, &quad.arg2 })
+        {
+            switch (operand->kind)
+            {
+            case Operand::Kind::Variable:
+                operand->id = variables[operand->id];
+                break;
+            case Operand::Kind::Temp:
+                operand->id += tempOffset;
+                break;
+            case Operand::Kind::Constant:
+                operand->id = constants[operand->id];
+                break;
+            case Operand::Kind::None:
+                break;
+            }
+        }
+        m_program.quads.push_back(quad);
+    }
+}
+
+ThreeAddressCode ChunkMerger::Finish()
+{
+    m_variableIds.clear();
+    m_constantIds.clear();
+    return std::move(m_program);
+}
+
+ThreeAddressCode MergeChunks(std::vector<ThreeAddressCode>&& chunks)
+{
+    ChunkMerger merger;
+    for (const ThreeAddressCode& chunk : chunks)
+        merger.Append(chunk);
+
+    return merger.Finish();
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <queue>
+#include <vector>
+#include <unordered_map>
+
+#include "semantic_actions.h"
+#include "tokenizer.h"
+
+// A run of whole statements of a program, with the declarations made by the
+// statements before it of the names that the chunk uses.
+struct ProgramChunk
+{
+    TokenQueue tokens;
+    SymbolTable symbols;
+};
+
+// Splits the tokens of a program into at most count chunks of about the same
+// size. Chunks end only after an assignment, so each one is a program of its
+// own, G -> G Declarations Assign, and all of its reductions come after those
+// of the chunks before it. The declarations are collected by a sequential
+// scan over the statements; a chunk gets only those of the names it uses, so
+// the whole table is not copied into every chunk.
+std::vector<ProgramChunk> SplitProgram(TokenQueue&& tokens, size_t count);
+
+// Declarations made by one statement, added to symbols the way the
+// Declaration action does.
+void CollectDeclaration(SymbolTable& symbols, const std::vector<Token>& statement);
+
+// Concatenates the code of chunks compiled separately. Variables and
+// constants are matched by name, temporaries of each chunk are shifted past
+// those of the chunks before it, which gives the same code as compiling the
+// whole program at once.
+class ChunkMerger
+{
+public:
+    void Append(const ThreeAddressCode& chunk);
+    ThreeAddressCode Finish();
+
+private:
+    ThreeAddressCode m_program;
+    std::unordered_map<std::string, uint32_t> m_variableIds;
+    std::unordered_map<std::string, uint32_t> m_constantIds;
+};
+
+ThreeAddressCode MergeChunks(std::vector<ThreeAddressCode>&& chunks);
@@ -0,0 +1,219 @@
+#include <set>
+#include <vector>
+#include <queue>
+#include <limits>
+#include <functional>
+
+#include <compiler/register_allocator.h>
+
+namespace
+{
+    // Hands out the lowest free index of an unbounded set of locations.
+    class Locations
+    {
+    public:
+        explicit Locations(size_t limit = std::numeric_limits<size_t>::max())
+            : m_limit(limit)
+        {
+        }
+
+        bool Available() const
+        {
+            return !m_free.empty() || m_used < m_limit;
+        }
+
+        uint32_t Take()
+        {
+            if (m_free.empty())
+                return static_cast<uint32_t>(m_used++);
+
+            const uint32_t index = m_free.top();
+            m_free.pop();
+            return index;
+        }
+
+        void Release(uint32_t index)
+        {
+            m_free.push(index);
+        }
+
+        size_t Used() const
+        {
+            return m_used;
+        }
+
+    private:
+        std::priority_queue<uint32_t, std::vector<uint32_t>, std::greater<>> m_free;
+        size_t m_used{ 0 };
+        size_t m_limit;
+    };
+
+    // Spill slots with the position from which each free one has been free,
+    // so that an interval starting before the current position only gets a
+    // slot that nothing used since.
+    class SpillSlots
+    {
+    public:
+        uint32_t Take(size_t start)
+        {
+            for (uint32_t slot = 0; slot < m_freeSince.size(); slot++)
+            {
+                if (m_freeSince[slot] <= start)
+                {
+                    m_freeSince[slot] = Occupied;
+                    return slot;
+                }
+            }
+
+            m_freeSince.push_back(Occupied);
+            return static_cast<uint32_t>(m_freeSince.size() - 1);
+        }
+
+        void Release(uint32_t slot, size_t position)
+        {
+            m_freeSince[slot] = position;
+        }
+
+        size_t Used() const
+        {
+            return m_freeSince.size();
+        }
+
+    private:
+        static constexpr size_t Occupied = std::numeric_limits<size_t>::max();
+
+        std::vector<size_t> m_freeSince;
+    };
+
+    // Intervals currently holding a location, ordered by their end.
+    using Active = std::set<std::pair<size_t, uint32_t>>;
+
+    // The result of a quad may take the location of an operand it reads last.
+    template<typename Release>
+    void Expire(Active& active, size_t position, const std::vector<TempLocation>& temps, Release&& release)
+    {
+        while (!active.empty() && active.begin()->first <= position)
+        {
+            release(temps[active.begin()->second].index, active.begin()->first);
+            active.erase(active.begin());
+        }
+    }
+}
+
+std::vector<LiveInterval> ComputeLiveIntervals(const ThreeAddressCode& code)
+{
+    constexpr size_t none = std::numeric_limits<size_t>::max();
+    std::vector<size_t> intervalOf(code.temps.size(), none);
+    std::vector<LiveInterval> intervals;
+
+    for (size_t i = 0; i < code.quads.size(); i++)
+    {
+        const Quad& quad = code.quads[i];
+        for (const Operand* use : { &quad.arg1, &quad.arg2 })
+        {
+            if (use->kind == Operand::Kind::Temp && intervalOf[use->id] != none)
+                intervals[intervalOf[use->id]].end = i;
+        }
+
+        if (quad.result.kind != Operand::Kind::Temp)
+            continue;
+
+        if (quad.op == OpCode::Store)
+        {
+            if (intervalOf[quad.result.id] != none)
+                intervals[intervalOf[quad.result.id]].end = i;
+        }
+        else if (intervalOf[quad.result.id] == none)
+        {
+            intervalOf[quad.result.id] = intervals.size();
+            intervals.push_back(LiveInterval{ quad.result.id, i, i });
+        }
+    }
+
+    return intervals;
+}
+
+RegisterAllocation AllocateRegisters(const ThreeAddressCode& code, size_t registers)
+{
+    RegisterAllocation allocation;
+    allocation.temps.resize(code.temps.size());
+    auto& temps = allocation.temps;
+
+    Locations freeRegisters(registers);
+    SpillSlots freeSlots;
+    Active active;
+    Active spilled;
+
+    // The slot must be free over the whole interval, also before the
+    // current position when a victim is evicted.
+    const auto spill = [&](const LiveInterval& interval)
+    {
+        temps[interval.temp] = TempLocation{ TempLocation::Kind::Spill, freeSlots.Take(interval.start) };
+        spilled.emplace(interval.end, interval.temp);
+    };
+
+    std::vector<size_t> starts(code.temps.size(), 0);
+    for (const LiveInterval& interval : ComputeLiveIntervals(code))
+    {
+        starts[interval.temp] = interval.start;
+
+        Expire(active, interval.start, temps, [&freeRegisters](uint32_t index, size_t) { freeRegisters.Release(index); });
+        Expire(spilled, interval.start, temps, [&freeSlots](uint32_t index, size_t end) { freeSlots.Release(index, end); });
+
+        if (freeRegisters.Available())
+        {
+            temps[interval.temp] = TempLocation{ TempLocation::Kind::Register, freeRegisters.Take() };
+            active.emplace(interval.end, interval.temp);
+            continue;
+        }
+
+        if (active.empty() || std::prev(active.end())->first <= interval.end)
+        {
+            spill(interval);
+            continue;
+        }
+
+        // The active interval that ends last gives its register away.
+        const auto [end, victim] = *std::prev(active.end());
+        active.erase(std::prev(active.end()));
+
+        temps[interval.temp] = temps[victim];
+        active.emplace(interval.end, interval.temp);
+        spill(LiveInterval{ victim, starts[victim], end });
+    }
+
+    allocation.registers = freeRegisters.Used();
+    allocation.spillSlots = freeSlots.Used();
+    return allocation;
+}
+
+void AssignRegisters(ThreeAddressCode& code, const RegisterAllocation& allocation)
+{
+    const auto locationId = [&allocation](uint32_t temp)
+    {
+        const TempLocation& location = allocation.temps[temp];
+        return static_cast<uint32_t>(location.kind == TempLocation::Kind::Spill ? allocation.registers + location.index : location.index);
+    };
+
+    std::vector<IrTemp> locations(allocation.registers + allocation.spillSlots);
+    for (uint32_t temp = 0; temp < code.temps.size(); temp++)
+    {
+        if (allocation.temps[temp].kind == TempLocation::Kind::None)
+            continue;
+
+        IrTemp& location = locations[locationId(temp)];
+        if (location.size < code.temps[temp].size)
+            location = code.temps[temp];
+    }
+
+    for (Quad& quad : code.quads)
+    {
+        for (Operand* operand : { &quad.result, &quad.arg1, &quad.arg2 })
+        {
+            if (operand->kind == Operand::Kind::Temp)
+                operand->id = locationId(operand->id);
+        }
+    }
+
+    code.temps = std::move(locations);
+}
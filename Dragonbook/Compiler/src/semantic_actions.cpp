@@ -0,0 +1,564 @@
+#include <limits>
+#include <charconv>
+#include <optional>
+#include <algorithm>
+#include <string_view>
+#include <boost/lexical_cast.hpp>
+
+#include "semantic_actions.h"
+
+namespace
+{
+    ScalarType GetScalarType(const std::string& basicType)
+    {
+        if (basicType == "int")
+            return ScalarType::Int;
+        else if (basicType == "float")
+            return ScalarType::Float;
+        else
+            throw std::invalid_argument("");
+    }
+
+    size_t GetSizeOf(ScalarType type)
+    {
+        return (type == ScalarType::Float) ? 4 : 8;
+    }
+
+    Operand NewTemp(TranslationState& state, ScalarType type, size_t size)
+    {
+        const auto id = state.flushedTemps + static_cast<uint32_t>(state.program.temps.size());
+        state.program.temps.push_back(IrTemp{ type, size });
+        return Operand{ Operand::Kind::Temp, id };
+    }
+
+    constexpr uint32_t NoVariable = ~uint32_t{ 0 };
+
+    Operand VariableOperand(TranslationState& state, NameId name)
+    {
+        if (state.variableIds.size() <= name)
+            state.variableIds.resize(state.symbols.Size(), NoVariable);
+
+        uint32_t& id = state.variableIds[name];
+        if (id == NoVariable)
+        {
+            id = static_cast<uint32_t>(state.program.variables.size());
+            state.program.variables.push_back(IrVariable{ state.symbols.Name(name) });
+        }
+
+        return Operand{ Operand::Kind::Variable, id };
+    }
+
+    Operand VariableOperand(TranslationState& state, std::string_view name)
+    {
+        return VariableOperand(state, state.symbols.Intern(name));
+    }
+
+    // Type of an array accessed with this many indexes. Throws if the array
+    // has fewer dimensions, naming the first missing level as name[]...[].
+    const TypeDescriptor& ArrayType(const TranslationState& state, NameId name, size_t indexes)
+    {
+        const TypeDescriptor* type = state.symbols.TypeOf(name);
+        if (!type || type->Rank() < indexes)
+        {
+            std::string missing = state.symbols.Name(name);
+            for (size_t i = type ? type->levels.size() : 1; i > 0; --i)
+                missing += "[]";
+            throw std::runtime_error("Undefined symbol '" + missing + "'");
+        }
+
+        return *type;
+    }
+
+    Operand ConstantOperand(TranslationState& state, const std::string& text)
+    {
+        const auto [it, inserted] = state.constantIds.try_emplace(text, static_cast<uint32_t>(state.program.constants.size()));
+        if (inserted)
+        {
+            // A literal too large for 64 bits keeps only its text; it is an
+            // error only for the passes that evaluate it.
+            std::optional<int64_t> value;
+            int64_t parsed = 0;
+            const auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), parsed);
+            if (ec == std::errc{} && end == text.data() + text.size())
+                value = parsed;
+
+            state.program.constants.push_back(IrConstant{ text, value });
+        }
+
+        return Operand{ Operand::Kind::Constant, it->second };
+    }
+
+    Operand ConstantOperand(TranslationState& state, int64_t value)
+    {
+        const auto it = state.constantValues.find(value);
+        if (it != state.constantValues.end())
+            return Operand{ Operand::Kind::Constant, it->second };
+
+        const Operand constant = ConstantOperand(state, std::to_string(value));
+        state.constantValues.emplace(value, constant.id);
+        return constant;
+    }
+
+    // Constant operand of the stride of an index, made once per array type.
+    Operand StrideOperand(TranslationState& state, const TypeDescriptor& type, size_t index)
+    {
+        auto& strides = type.strideOperands;
+        if (strides.size() < type.Rank())
+            strides.resize(type.Rank());
+
+        if (strides[index].kind == Operand::Kind::None)
+            strides[index] = ConstantOperand(state, static_cast<int64_t>(type.Stride(index)));
+
+        return strides[index];
+    }
+
+    bool IsConstant(const Operand& operand)
+    {
+        return operand.kind == Operand::Kind::Constant;
+    }
+
+    // Constant with a 64-bit value that folding can compute with.
+    bool IsFoldable(const TranslationState& state, const Operand& operand)
+    {
+        return IsConstant(operand) && state.program.constants[operand.id].value.has_value();
+    }
+
+    std::optional<int64_t> FoldConstants(OpCode op, int64_t lhs, int64_t rhs)
+    {
+        constexpr auto min = std::numeric_limits<int64_t>::min();
+        constexpr auto max = std::numeric_limits<int64_t>::max();
+
+        switch (op)
+        {
+        case OpCode::Add:
+            if ((rhs > 0 && lhs > max - rhs) || (rhs < 0 && lhs < min - rhs))
+                return std::nullopt;
+            return lhs + rhs;
+        case OpCode::Sub:
+            if ((rhs < 0 && lhs > max + rhs) || (rhs > 0 && lhs < min + rhs))
+                return std::nullopt;
+            return lhs - rhs;
+        case OpCode::Mul:
+        {
+            if (lhs == 0 || rhs == 0)
+                return 0;
+
+            const auto product = static_cast<int64_t>(static_cast<uint64_t>(lhs) * static_cast<uint64_t>(rhs));
+            if ((lhs == -1 && rhs == min) || (rhs == -1 && lhs == min) || product / rhs != lhs)
+                return std::nullopt;
+            return product;
+        }
+        case OpCode::Div:
+            if (rhs == 0 || (lhs == min && rhs == -1))
+                return std::nullopt;
+            return lhs / rhs;
+        default:
+            return std::nullopt;
+        }
+    }
+
+    // Emits result = lhs op rhs into code and returns the operand holding the
+    // result. With constant folding enabled, arithmetic on constants and
+    // operations with a neutral element emit nothing.
+    Operand EmitArithmetic(TranslationState& state, CodeBuffer& code, OpCode op, const Operand& lhs, const Operand& rhs, ScalarType type)
+    {
+        if (state.options.foldConstants)
+        {
+            const auto& constants = state.program.constants;
+            const auto isValue = [&constants](const Operand& operand, int64_t value)
+            {
+                return IsConstant(operand) && constants[operand.id].value == value;
+            };
+
+            if (IsFoldable(state, lhs) && IsFoldable(state, rhs))
+            {
+                if (const auto value = FoldConstants(op, *constants[lhs.id].value, *constants[rhs.id].value))
+                    return ConstantOperand(state, *value);
+            }
+
+            if (((op == OpCode::Add || op == OpCode::Sub) && isValue(rhs, 0))
+                || ((op == OpCode::Mul || op == OpCode::Div) && isValue(rhs, 1)))
+                return lhs;
+
+            if ((op == OpCode::Add && isValue(lhs, 0)) || (op == OpCode::Mul && isValue(lhs, 1)))
+                return rhs;
+        }
+
+        const Operand temp = NewTemp(state, type, 8);
+        code.Emit({ op, temp, lhs, rhs });
+        return temp;
+    }
+
+    // Constant-folding variant of ParseArray. The offset is computed in Horner
+    // form over the array dimensions, ((i0 * d1 + i1) * d2 + i2) * w, keeping
+    // the constant part of it and the pending multiplier apart from the
+    // variable part, so that constant indexes collapse into one literal and
+    // every variable index costs at most one multiplication and one addition.
+    std::pair<Operand, CodeBuffer> ParseArrayFolded(TranslationState& state, Array&& arr, bool rValue)
+    {
+        const NameId name = arr.name;
+        const TypeDescriptor& type = ArrayType(state, name, arr.indexes.size());
+        const auto stride = [&type](size_t index) { return static_cast<int64_t>(type.Stride(index)); };
+
+        const auto checked = [](std::optional<int64_t> value)
+        {
+            if (!value)
+                throw std::runtime_error("Array offset is out of range");
+            return *value;
+        };
+
+        CodeBuffer newCode = std::move(arr.lines);
+        std::optional<Operand> variable;
+        int64_t multiplier = 1;
+        int64_t constant = 0;
+
+        for (size_t i = 0; i < arr.indexes.size(); ++i)
+        {
+            const Operand& index = arr.indexes[i];
+            // A zero stride comes from a zero dimension further in, which
+            // makes the offset of this index and of those before it zero.
+            const int64_t dimension = (i == 0) ? 1 : (stride(i) == 0) ? 0 : stride(i - 1) / stride(i);
+            multiplier = checked(FoldConstants(OpCode::Mul, multiplier, dimension));
+            constant = checked(FoldConstants(OpCode::Mul, constant, dimension));
+
+            if (IsFoldable(state, index))
+            {
+                constant = checked(FoldConstants(OpCode::Add, constant, *state.program.constants[index.id].value));
+                continue;
+            }
+
+            if (variable)
+            {
+                const Operand scaled = EmitArithmetic(state, newCode, OpCode::Mul, *variable, ConstantOperand(state, multiplier), ScalarType::Size);
+                variable = EmitArithmetic(state, newCode, OpCode::Add, scaled, index, ScalarType::Size);
+            }
+            else
+            {
+                variable = index;
+            }
+            multiplier = 1;
+        }
+
+        multiplier = checked(FoldConstants(OpCode::Mul, multiplier, stride(arr.indexes.size() - 1)));
+        constant = checked(FoldConstants(OpCode::Mul, constant, stride(arr.indexes.size() - 1)));
+
+        Operand offset = ConstantOperand(state, constant);
+        if (variable)
+        {
+            offset = EmitArithmetic(state, newCode, OpCode::Mul, *variable, ConstantOperand(state, multiplier), ScalarType::Size);
+            offset = EmitArithmetic(state, newCode, OpCode::Add, offset, ConstantOperand(state, constant), ScalarType::Size);
+        }
+
+        const TypeLevel& element = type.levels[arr.indexes.size()];
+        const Operand temp = NewTemp(state, element.scalar, element.size);
+        const Operand array = VariableOperand(state, name);
+        newCode.Emit({ rValue ? OpCode::Load : OpCode::Address, temp, array, offset });
+
+        return { temp, std::move(newCode) };
+    }
+
+    // Emits the address computation for an array access. Returns the temp that
+    // holds the element (rValue) or its address, and the code computing it.
+    std::pair<Operand, CodeBuffer> ParseArray(TranslationState& state, Array&& arr, bool rValue)
+    {
+        if (state.options.foldConstants)
+            return ParseArrayFolded(state, std::move(arr), rValue);
+
+        const NameId name = arr.name;
+        const TypeDescriptor& type = ArrayType(state, name, arr.indexes.size());
+
+        CodeBuffer newCode = std::move(arr.lines);
+        std::pmr::vector<Operand> vars{ CurrentMemoryResource() };
+        vars.reserve(arr.indexes.size());
+
+        for (size_t i = 0; i < arr.indexes.size(); ++i)
+        {
+            const Operand& index = arr.indexes[i];
+
+            const Operand offset = NewTemp(state, ScalarType::Size, 8);
+            newCode.Emit({ OpCode::Mul, offset, index, StrideOperand(state, type, i) });
+            vars.push_back(offset);
+        }
+
+        Operand newResult = vars.front();
+        if (vars.size() > 1)
+        {
+            newResult = NewTemp(state, ScalarType::Size, 8);
+            newCode.Emit({ OpCode::Add, newResult, vars[0], vars[1] });
+
+            for (size_t i = 2; i < vars.size(); ++i)
+            {
+                const Operand nextTemp = NewTemp(state, ScalarType::Size, 8);
+                newCode.Emit({ OpCode::Add, nextTemp, newResult, vars[i] });
+                newResult = nextTemp;
+            }
+        }
+
+        const TypeLevel& element = type.levels[arr.indexes.size()];
+        const Operand temp = NewTemp(state, element.scalar, element.size);
+        const Operand array = VariableOperand(state, name);
+        newCode.Emit({ rValue ? OpCode::Load : OpCode::Address, temp, array, newResult });
+
+        return { temp, std::move(newCode) };
+    }
+
+    void NoAction(TranslationState&, std::span<Annotation>, Annotation&)
+    {
+    }
+
+    // G' -> G
+    // Expr -> ( Expr )
+    template<size_t Index>
+    void PassCode(TranslationState&, std::span<Annotation> rhs, Annotation& result)
+    {
+        result.code() = std::move(rhs[Index].code());
+    }
+
+    // G -> G Declarations Assign
+    void Program(TranslationState& state, std::span<Annotation> rhs, Annotation& result)
+    {
+        auto& lines = result.code().lines;
+        lines = std::move(rhs[0].code().lines);
+        lines.Append(std::move(rhs[1].code().lines));
+        lines.Append(std::move(rhs[2].code().lines));
+
+        if (state.sink)
+        {
+            auto& program = state.program;
+            program.quads = lines.Flatten();
+            lines = CodeBuffer{};
+            state.sink(program);
+
+            program.quads.clear();
+            state.flushedTemps += static_cast<uint32_t>(program.temps.size());
+            program.temps.clear();
+        }
+    }
+
+    // Assign -> id = Expr ;
+    void AssignVariable(TranslationState& state, std::span<Annotation> rhs, Annotation& result)
+    {
+        const Operand variable = VariableOperand(state, rhs[0].token().second);
+        Code& exprCode = rhs[2].code();
+
+        Code& code = result.code();
+        code.lines = std::move(exprCode.lines);
+        code.lines.Emit({ OpCode::Copy, variable, exprCode.result });
+        code.result = variable;
+    }
+
+    // Assign -> Array = Expr ;
+    void AssignArray(TranslationState& state, std::span<Annotation> rhs, Annotation& result)
+    {
+        auto arr = ParseArray(state, std::move(rhs[0].arr()), false);
+        Code& exprCode = rhs[2].code();
+
+        Code& code = result.code();
+        code.lines = std::move(exprCode.lines);
+        code.lines.Append(std::move(arr.second));
+        code.lines.Emit({ OpCode::Store, arr.first, exprCode.result });
+    }
+
+    // Expr -> Expr op Expr
+    template<OpCode Op>
+    void BinaryOp(TranslationState& state, std::span<Annotation> rhs, Annotation& result)
+    {
+        Code& lhsCode = rhs[0].code();
+        Code& rhsCode = rhs[2].code();
+
+        Code& code = result.code();
+        code.lines = std::move(lhsCode.lines);
+        code.lines.Append(std::move(rhsCode.lines));
+        code.result = EmitArithmetic(state, code.lines, Op, lhsCode.result, rhsCode.result, ScalarType::Int);
+    }
+
+    // Expr -> - Expr
+    void Negate(TranslationState& state, std::span<Annotation> rhs, Annotation& result)
+    {
+        Code& exprCode = rhs[1].code();
+
+        Code& code = result.code();
+        code.lines = std::move(exprCode.lines);
+        code.result = EmitArithmetic(state, code.lines, OpCode::Sub, ConstantOperand(state, "0"), exprCode.result, ScalarType::Int);
+    }
+
+    // Expr -> id
+    void Variable(TranslationState& state, std::span<Annotation> rhs, Annotation& result)
+    {
+        const auto& varName = rhs[0].token().second;
+        const NameId name = state.symbols.Find(varName);
+        if (!state.symbols.TypeOf(name))
+            throw std::runtime_error("Undefined symbol '" + varName + "'");
+
+        result.code().result = VariableOperand(state, name);
+    }
+
+    // Expr -> Array
+    void ArrayElement(TranslationState& state, std::span<Annotation> rhs, Annotation& result)
+    {
+        auto res = ParseArray(state, std::move(rhs[0].arr()), true);
+
+        Code& code = result.code();
+        code.result = res.first;
+        code.lines = std::move(res.second);
+    }
+
+    // Expr -> num
+    void Number(TranslationState& state, std::span<Annotation> rhs, Annotation& result)
+    {
+        result.code().result = ConstantOperand(state, rhs[0].token().second);
+    }
+
+    // Array -> id [ Expr ]
+    void ArrayFirstIndex(TranslationState& state, std::span<Annotation> rhs, Annotation& result)
+    {
+        Code& indexCode = rhs[2].code();
+
+        Array& arr = result.arr();
+        arr.name = state.symbols.Intern(rhs[0].token().second);
+        arr.lines = std::move(indexCode.lines);
+        arr.indexes.push_back(indexCode.result);
+    }
+
+    // Array -> Array [ Expr ]
+    void ArrayNextIndex(TranslationState&, std::span<Annotation> rhs, Annotation& result)
+    {
+        Code& indexCode = rhs[2].code();
+
+        Array& arr = result.arr();
+        arr = std::move(rhs[0].arr());
+        arr.lines.Append(std::move(indexCode.lines));
+        arr.indexes.push_back(indexCode.result);
+    }
+
+    // Declarations -> Declaration ; Declarations
+    void Declarations(TranslationState&, std::span<Annotation> rhs, Annotation& result)
+    {
+        result.code().lines = std::move(rhs[2].code().lines);
+    }
+
+    // Declarations -> Declaration = Expr ; Declarations
+    void InitializedDeclarations(TranslationState& state, std::span<Annotation> rhs, Annotation& result)
+    {
+        const Operand variable = VariableOperand(state, rhs[0].decl().name);
+        Code& exprCode = rhs[2].code();
+
+        Code& code = result.code();
+        code.lines = std::move(exprCode.lines);
+        code.lines.Emit({ OpCode::Copy, variable, exprCode.result });
+        code.lines.Append(std::move(rhs[4].code().lines));
+        code.result = variable;
+    }
+
+    // Declaration -> BasicType IndexesOptional id
+    void Declaration(TranslationState& state, std::span<Annotation> rhs, Annotation& result)
+    {
+        auto varName = std::move(rhs[2].token().second);
+        DeclareSymbol(state.symbols, std::move(rhs[0].decl().name), varName, rhs[1].decl().dimensions);
+
+        const NameId name = state.symbols.Find(varName);
+        IrVariable& variable = state.program.variables[VariableOperand(state, name).id];
+        if (variable.type.empty())
+        {
+            const TypeLevel& type = state.symbols.TypeOf(name)->levels.front();
+            variable.type = TypeName(type);
+            variable.size = type.size;
+        }
+
+        result.decl().name = std::move(varName);
+    }
+
+    // BasicType -> int
+    // BasicType -> float
+    void BasicType(TranslationState&, std::span<Annotation> rhs, Annotation& result)
+    {
+        result.decl().name = std::move(rhs[0].token().first);
+    }
+
+    // IndexesOptional -> [ num ] IndexesOptional
+    void Indexes(TranslationState&, std::span<Annotation> rhs, Annotation& result)
+    {
+        auto& dimensions = result.decl().dimensions;
+        dimensions = std::move(rhs[3].decl().dimensions);
+        dimensions.insert(dimensions.begin(), std::move(rhs[1].token().second));
+    }
+
+    struct SemanticRule
+    {
+        std::string_view production;
+        SemanticActions::Handler handler;
+    };
+
+    constexpr SemanticRule Rules[] = {
+        { "G' -> G", &PassCode<0> },
+        { "G -> G Declarations Assign", &Program },
+        { "G -> ''", &NoAction },
+        { "Assign -> id = Expr ;", &AssignVariable },
+        { "Assign -> Array = Expr ;", &AssignArray },
+        { "Assign -> ''", &NoAction },
+        { "Expr -> Expr * Expr", &BinaryOp<OpCode::Mul> },
+        { "Expr -> Expr / Expr", &BinaryOp<OpCode::Div> },
+        { "Expr -> Expr + Expr", &BinaryOp<OpCode::Add> },
+        { "Expr -> Expr - Expr", &BinaryOp<OpCode::Sub> },
+        { "Expr -> - Expr", &Negate },
+        { "Expr -> ( Expr )", &PassCode<1> },
+        { "Expr -> id", &Variable },
+        { "Expr -> Array", &ArrayElement },
+        { "Expr -> num", &Number },
+        { "Array -> id [ Expr ]", &ArrayFirstIndex },
+        { "Array -> Array [ Expr ]", &ArrayNextIndex },
+        { "Declarations -> Declaration ; Declarations", &Declarations },
+        { "Declarations -> Declaration = Expr ; Declarations", &InitializedDeclarations },
+        { "Declarations -> ''", &NoAction },
+        { "Declaration -> BasicType IndexesOptional id", &Declaration },
+        { "BasicType -> int", &BasicType },
+        { "BasicType -> float", &BasicType },
+        { "IndexesOptional -> [ num ] IndexesOptional", &Indexes },
+        { "IndexesOptional -> ''", &NoAction },
+    };
+}
+
+SemanticActions SemanticActions::Bind(const std::vector<std::string>& productions)
+{
+    SemanticActions actions;
+    for (const auto& production : productions)
+    {
+        const auto rule = std::find_if(std::begin(Rules), std::end(Rules),
+            [&production](const SemanticRule& r) {
+                return r.production == production;
+            }
+        );
+
+        if (rule == std::end(Rules))
+            throw std::runtime_error("No semantic action for production '" + production + "'");
+
+        actions.m_handlers.push_back(rule->handler);
+    }
+
+    return actions;
+}
+
+void DeclareSymbol(SymbolTable& symbols, const std::string& typeName, const std::string& name, const std::vector<std::string>& dimensions)
+{
+    TypeDescriptor type;
+    type.levels.resize(dimensions.size() + 1);
+
+    const ScalarType scalar = GetScalarType(typeName);
+    auto size = GetSizeOf(scalar);
+    type.levels.back() = TypeLevel{ scalar, 0, size };
+
+    for (size_t i = dimensions.size(); i > 0; --i)
+    {
+        size *= boost::lexical_cast<size_t>(dimensions[i - 1]);
+        type.levels[i - 1] = TypeLevel{ scalar, static_cast<uint32_t>(dimensions.size() - i + 1), size };
+    }
+
+    symbols.Declare(name, type);
+}
+
+ThreeAddressCode FinishTranslation(TranslationState&& state, Annotation&& root)
+{
+    ThreeAddressCode program = std::move(state.program);
+    program.quads = root.code().lines.Flatten();
+    return program;
+}
@@ -0,0 +1,156 @@
+#pragma once
+
+#include <span>
+#include <string>
+#include <vector>
+#include <utility>
+#include <variant>
+#include <functional>
+#include <unordered_map>
+
+#include <compiler/compiler.h>
+#include "grammar_reader.h"
+#include "code_buffer.h"
+#include "symbol_table.h"
+
+using Token = std::pair<std::string, std::string>;
+
+struct Code
+{
+    Operand result;
+    CodeBuffer lines;
+};
+
+struct Array
+{
+    NameId name{ SymbolTable::NoName };
+    std::pmr::vector<Operand> indexes{ CurrentMemoryResource() };
+    CodeBuffer lines;
+};
+
+// Type and name collected while reducing a declaration.
+struct DeclarationInfo
+{
+    std::string name;
+    std::vector<std::string> dimensions;
+};
+
+// Attribute of one grammar symbol on the parse stack. Every symbol carries
+// only one kind of attribute, so they share storage. Annotations are
+// move-only: semantic actions take their right-hand side in place and move
+// what they need into the result.
+class Annotation
+{
+public:
+    Annotation() = default;
+    explicit Annotation(Token&& t)
+        : m_value(std::move(t))
+    {
+    }
+
+    Annotation(Annotation&&) = default;
+    Annotation& operator=(Annotation&&) = default;
+    Annotation(const Annotation&) = delete;
+    Annotation& operator=(const Annotation&) = delete;
+
+    bool isToken() const { return std::holds_alternative<Token>(m_value); }
+
+    // Symbols derived from an empty production have no attribute yet; asking
+    // for one gives an empty value.
+    Token& token() { return Get<Token>(); }
+    Code& code() { return Get<Code>(); }
+    Array& arr() { return Get<Array>(); }
+    DeclarationInfo& decl() { return Get<DeclarationInfo>(); }
+
+private:
+    template<typename T>
+    T& Get()
+    {
+        if (std::holds_alternative<std::monostate>(m_value))
+            return m_value.emplace<T>();
+
+        return std::get<T>(m_value);
+    }
+
+    std::variant<std::monostate, Token, Code, Array, DeclarationInfo> m_value;
+};
+
+// Receives the code of one top-level statement. Its temporaries keep their
+// numbers in the whole program, code.temps only lists the ones of the
+// statement.
+using StatementSink = std::function<void(const ThreeAddressCode& code)>;
+
+// Per-compile state shared by the semantic actions.
+struct TranslationState
+{
+    CompileOptions options;
+    SymbolTable symbols;
+    // Index into program.variables of every interned name, NoVariable for
+    // names not used as variables yet.
+    std::pmr::vector<uint32_t> variableIds{ CurrentMemoryResource() };
+    std::pmr::unordered_map<std::string, uint32_t> constantIds{ CurrentMemoryResource() };
+    // Constants computed by the translation, e.g. folded offsets, by value.
+    std::pmr::unordered_map<int64_t, uint32_t> constantValues{ CurrentMemoryResource() };
+    // Variable, temporary and constant tables; the quads are collected from
+    // the root annotation by FinishTranslation.
+    ThreeAddressCode program;
+
+    // If set, the code of every G -> G Declarations Assign goes here when it
+    // is reduced, together with its temporaries, instead of being kept.
+    StatementSink sink;
+    // Number of temporaries handed to the sink so far.
+    uint32_t flushedTemps{ 0 };
+};
+
+ThreeAddressCode FinishTranslation(TranslationState&& state, Annotation&& root);
+
+// Declares name with the type "typeName[d0][d1]...", whose levels are
+// typeName[d0][d1]..., typeName[d1]..., ... down to typeName. A name that is
+// already declared keeps its first declaration, see SymbolTable::Declare.
+void DeclareSymbol(SymbolTable& symbols, const std::string& typeName, const std::string& name, const std::vector<std::string>& dimensions);
+
+// Semantic actions of the grammar indexed by production number. They are
+// bound once per grammar by matching the text of each production, so a
+// reduction is a single indirect call.
+class SemanticActions
+{
+public:
+    using Handler = void (*)(TranslationState& state, std::span<Annotation> rhs, Annotation& result);
+
+    // Throws if some production of the grammar has no semantic action.
+    template<typename Table>
+    static SemanticActions Bind(const Table& table)
+    {
+        return Bind(Productions(table));
+    }
+
+    static SemanticActions Bind(const std::vector<std::string>& productions);
+
+    // Text of every production of the grammar, "A -> B c" or "A -> ''".
+    template<typename Table>
+    static std::vector<std::string> Productions(const Table& table)
+    {
+        std::vector<std::string> productions;
+        for (size_t p = 0; p < table.ProductionsCount(); ++p)
+        {
+            std::string production = std::string(table.SymbolName(table.ProductionLhs(p))) + " ->";
+            for (const SymbolId symbol : table.ProductionRhs(p))
+                production += " " + std::string(table.SymbolName(symbol));
+
+            if (table.ProductionRhs(p).empty())
+                production += " ''";
+
+            productions.push_back(std::move(production));
+        }
+
+        return productions;
+    }
+
+    void Reduce(size_t production, TranslationState& state, std::span<Annotation> rhs, Annotation& result) const
+    {
+        m_handlers[production](state, rhs, result);
+    }
+
+private:
+    std::vector<Handler> m_handlers;
+};
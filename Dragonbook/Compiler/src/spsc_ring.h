@@ -0,0 +1,70 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <cstddef>
+
+// Bounded lock-free queue for exactly one producer and one consumer thread.
+// Each side owns one index and only reads the other's; the release store of
+// an index publishes the slots written before it.
+template<typename T>
+class SpscRing
+{
+public:
+    // The capacity is rounded up to a power of two.
+    explicit SpscRing(size_t capacity)
+    {
+        size_t size = 2;
+        while (size < capacity)
+            size *= 2;
+
+        m_mask = size - 1;
+        m_slots = std::make_unique<T[]>(size);
+    }
+
+    // Producer side. Returns false if the ring is full.
+    bool TryPush(T&& value)
+    {
+        const size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_cachedHead > m_mask)
+        {
+            m_cachedHead = m_head.load(std::memory_order_acquire);
+            if (tail - m_cachedHead > m_mask)
+                return false;
+        }
+
+        m_slots[tail & m_mask] = std::move(value);
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side. Returns false if the ring is empty.
+    bool TryPop(T& value)
+    {
+        const size_t head = m_head.load(std::memory_order_relaxed);
+        if (head == m_cachedTail)
+        {
+            m_cachedTail = m_tail.load(std::memory_order_acquire);
+            if (head == m_cachedTail)
+                return false;
+        }
+
+        value = std::move(m_slots[head & m_mask]);
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    static constexpr size_t CacheLine = 64;
+
+    std::unique_ptr<T[]> m_slots;
+    size_t m_mask{ 0 };
+
+    // Written by the consumer, with the producer's last view of m_tail.
+    alignas(CacheLine) std::atomic<size_t> m_head{ 0 };
+    size_t m_cachedTail{ 0 };
+
+    // Written by the producer, with the consumer's last view of m_head.
+    alignas(CacheLine) std::atomic<size_t> m_tail{ 0 };
+    size_t m_cachedHead{ 0 };
+};
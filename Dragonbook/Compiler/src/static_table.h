@@ -0,0 +1,65 @@
+#pragma once
+
+#include <span>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+#include "grammar_reader.h"
+
+// Parse tables compiled into the binary. Data is a struct of constexpr arrays
+// emitted by grammar_tablegen; this wrapper gives it the same interface as
+// LalrTable so that LrAnalyzer can be instantiated against either.
+template<typename Data>
+struct StaticLalrTable
+{
+    static constexpr const Action& At(State state, SymbolId symbol)
+    {
+        return Data::actions[state * Data::symbolsCount + symbol];
+    }
+
+    static constexpr std::optional<SymbolId> FindTerminal(std::string_view name)
+    {
+        size_t first = 0;
+        size_t last = Data::terminalIndex.size();
+        while (first < last)
+        {
+            const size_t middle = first + (last - first) / 2;
+            const auto symbolName = SymbolName(Data::terminalIndex[middle]);
+            if (symbolName == name)
+                return Data::terminalIndex[middle];
+
+            if (symbolName < name)
+                first = middle + 1;
+            else
+                last = middle;
+        }
+        return std::nullopt;
+    }
+
+    static constexpr size_t StatesCount() { return Data::statesCount; }
+    static constexpr size_t SymbolsCount() { return Data::symbolsCount; }
+    static constexpr size_t ProductionsCount() { return Data::productionLhs.size(); }
+
+    static constexpr std::string_view SymbolName(SymbolId symbol)
+    {
+        return Data::symbolNames[symbol];
+    }
+
+    static constexpr bool IsNonTerminal(SymbolId symbol)
+    {
+        return Data::nonTerminals[symbol];
+    }
+
+    static constexpr SymbolId ProductionLhs(size_t production)
+    {
+        return Data::productionLhs[production];
+    }
+
+    static constexpr std::span<const SymbolId> ProductionRhs(size_t production)
+    {
+        return { Data::productionRhs.data() + Data::productionRhsIndex[production], Data::productionLength[production] };
+    }
+
+    static constexpr uint64_t SourceHash() { return Data::sourceHash; }
+};
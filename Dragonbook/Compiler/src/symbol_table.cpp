@@ -0,0 +1,103 @@
+#include <algorithm>
+#include <functional>
+
+#include "symbol_table.h"
+
+std::string TypeName(const TypeLevel& level)
+{
+    std::string name = (level.scalar == ScalarType::Float) ? "float" : "int";
+    for (uint32_t i = 0; i < level.brackets; ++i)
+        name += "[]";
+
+    return name;
+}
+
+size_t SymbolTable::Probe(std::string_view name, size_t hash) const
+{
+    const size_t mask = m_slots.size() - 1;
+    for (size_t i = hash & mask;; i = (i + 1) & mask)
+    {
+        const Slot& slot = m_slots[i];
+        if (slot.id == NoName || (slot.hash == hash && m_names[slot.id] == name))
+            return i;
+    }
+}
+
+void SymbolTable::Grow()
+{
+    std::vector<Slot> slots(std::max<size_t>(m_slots.size() * 2, 16));
+    std::swap(m_slots, slots);
+
+    const size_t mask = m_slots.size() - 1;
+    for (const Slot& slot : slots)
+    {
+        if (slot.id == NoName)
+            continue;
+
+        size_t i = slot.hash & mask;
+        while (m_slots[i].id != NoName)
+            i = (i + 1) & mask;
+        m_slots[i] = slot;
+    }
+}
+
+NameId SymbolTable::Intern(std::string_view name)
+{
+    // Keep the table at most half full so that probe runs stay short.
+    if (2 * (m_names.size() + 1) > m_slots.size())
+        Grow();
+
+    const size_t hash = std::hash<std::string_view>{}(name);
+    Slot& slot = m_slots[Probe(name, hash)];
+    if (slot.id == NoName)
+    {
+        slot = Slot{ hash, static_cast<NameId>(m_names.size()) };
+        m_names.emplace_back(name);
+        m_typeOf.push_back(NoType);
+    }
+
+    return slot.id;
+}
+
+NameId SymbolTable::Find(std::string_view name) const
+{
+    if (m_slots.empty())
+        return NoName;
+
+    return m_slots[Probe(name, std::hash<std::string_view>{}(name))].id;
+}
+
+const TypeDescriptor* SymbolTable::TypeOf(NameId id) const
+{
+    if (id == NoName || m_typeOf[id] == NoType)
+        return nullptr;
+
+    return &m_types[m_typeOf[id]];
+}
+
+const TypeDescriptor* SymbolTable::Lookup(std::string_view name) const
+{
+    return TypeOf(Find(name));
+}
+
+void SymbolTable::Declare(std::string_view name, const TypeDescriptor& type)
+{
+    const NameId id = Intern(name);
+    const TypeDescriptor* declared = TypeOf(id);
+
+    if (!declared)
+    {
+        m_typeOf[id] = static_cast<uint32_t>(m_types.size());
+        m_types.push_back(TypeDescriptor{ type.levels, {} });
+        return;
+    }
+
+    if (declared->levels.size() >= type.levels.size())
+        return;
+
+    TypeDescriptor extended{ declared->levels, {} };
+    extended.levels.insert(extended.levels.end(), type.levels.begin() + declared->levels.size(), type.levels.end());
+
+    m_typeOf[id] = static_cast<uint32_t>(m_types.size());
+    m_types.push_back(std::move(extended));
+}
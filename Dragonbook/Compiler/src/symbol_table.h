@@ -0,0 +1,100 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <string_view>
+
+#include <compiler/ir.h>
+
+using NameId = uint32_t;
+
+// What is left of a declared type after some indexes, e.g. int[] after one
+// index of int[4][3]. Its name is the scalar type followed by one pair of
+// brackets per remaining dimension, brackets in all, and size is its size in
+// bytes.
+struct TypeLevel
+{
+    ScalarType scalar{ ScalarType::Int };
+    uint32_t brackets{ 0 };
+    size_t size{ 0 };
+};
+
+// Name of a type level, e.g. "int[]".
+std::string TypeName(const TypeLevel& level);
+
+// Type of a declared name. levels[k] is what is left after applying k
+// indexes: levels[0] is the variable itself and levels.back() its element,
+// so the size of levels[k + 1] is the stride of index k.
+struct TypeDescriptor
+{
+    std::vector<TypeLevel> levels;
+    // Constant operands of the strides in the program being translated,
+    // kind None until an access first needs them. SymbolTable::Declare does
+    // not copy them, so they never leak into another program.
+    mutable std::vector<Operand> strideOperands;
+
+    size_t Rank() const
+    {
+        return levels.size() - 1;
+    }
+
+    size_t Stride(size_t index) const
+    {
+        return levels[index + 1].size;
+    }
+};
+
+// Names of a program interned into dense ids by an open-addressing hash
+// table, and the types declared for them. Looking up a name is a single hash
+// probe, and an array access finds the types and strides of all of its
+// indexes in the one descriptor.
+class SymbolTable
+{
+public:
+    static constexpr NameId NoName = ~NameId{ 0 };
+
+    // Id of name, interning it if it is new.
+    NameId Intern(std::string_view name);
+
+    // Id of name, or NoName if it was never interned.
+    NameId Find(std::string_view name) const;
+
+    // Number of interned names; ids are below it.
+    size_t Size() const
+    {
+        return m_names.size();
+    }
+
+    const std::string& Name(NameId id) const
+    {
+        return m_names[id];
+    }
+
+    // Type declared for the name, or nullptr. Valid until the next Declare.
+    const TypeDescriptor* TypeOf(NameId id) const;
+    const TypeDescriptor* Lookup(std::string_view name) const;
+
+    // The first declaration of a name is kept. A later one with more
+    // dimensions only adds the levels the first one lacks, so name[]...[]
+    // means the same as when every level was a symbol of its own.
+    void Declare(std::string_view name, const TypeDescriptor& type);
+
+private:
+    static constexpr uint32_t NoType = ~uint32_t{ 0 };
+
+    struct Slot
+    {
+        size_t hash{ 0 };
+        NameId id{ NoName };
+    };
+
+    size_t Probe(std::string_view name, size_t hash) const;
+    void Grow();
+
+    std::vector<Slot> m_slots;
+    std::vector<std::string> m_names;
+    // Descriptor index of every name, NoType if the name is not declared.
+    std::vector<uint32_t> m_typeOf;
+    std::vector<TypeDescriptor> m_types;
+};
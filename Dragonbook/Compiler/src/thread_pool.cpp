@@ -0,0 +1,108 @@
+#include <algorithm>
+
+#include "thread_pool.h"
+
+ThreadPool::ThreadPool(size_t threads)
+{
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+
+    for (size_t i = 0; i < threads; i++)
+        m_queues.push_back(std::make_unique<Queue>());
+
+    m_threads.reserve(threads);
+    for (size_t i = 0; i < threads; i++)
+        m_threads.emplace_back(&ThreadPool::Work, this, i);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+
+    for (auto& thread : m_threads)
+        thread.join();
+}
+
+size_t ThreadPool::Size() const
+{
+    return m_threads.size();
+}
+
+void ThreadPool::Submit(Task task)
+{
+    m_pending++;
+    {
+        std::lock_guard lock(m_mutex);
+        m_queued++;
+    }
+
+    Queue& queue = *m_queues[m_next++ % m_queues.size()];
+    {
+        std::lock_guard lock(queue.mutex);
+        queue.tasks.push_back(std::move(task));
+    }
+    m_wake.notify_one();
+}
+
+void ThreadPool::Wait()
+{
+    std::unique_lock lock(m_mutex);
+    m_done.wait(lock, [this] { return m_pending == 0; });
+}
+
+bool ThreadPool::TakeTask(size_t index, Task& task)
+{
+    {
+        Queue& own = *m_queues[index];
+        std::lock_guard lock(own.mutex);
+        if (!own.tasks.empty())
+        {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+
+    for (size_t i = 1; i < m_queues.size(); i++)
+    {
+        Queue& victim = *m_queues[(index + i) % m_queues.size()];
+        std::lock_guard lock(victim.mutex);
+        if (!victim.tasks.empty())
+        {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void ThreadPool::Work(size_t index)
+{
+    for (;;)
+    {
+        Task task;
+        if (TakeTask(index, task))
+        {
+            m_queued--;
+            task();
+
+            if (--m_pending == 0)
+            {
+                std::lock_guard lock(m_mutex);
+                m_done.notify_all();
+            }
+            continue;
+        }
+
+        std::unique_lock lock(m_mutex);
+        m_wake.wait(lock, [this] { return m_stop || m_queued > 0; });
+        if (m_stop)
+            return;
+    }
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <mutex>
+#include <deque>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <functional>
+#include <condition_variable>
+
+// Fixed set of worker threads with one task deque each. Tasks are spread over
+// the deques round-robin; a worker takes tasks from the back of its own deque
+// and, once it is empty, steals from the front of the others, so uneven tasks
+// do not leave threads idle.
+class ThreadPool
+{
+public:
+    using Task = std::function<void()>;
+
+    // 0 threads means one per hardware thread.
+    explicit ThreadPool(size_t threads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    size_t Size() const;
+
+    // Tasks must not throw.
+    void Submit(Task task);
+
+    // Blocks until every submitted task has finished.
+    void Wait();
+
+private:
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    void Work(size_t index);
+    bool TakeTask(size_t index, Task& task);
+
+    std::vector<std::unique_ptr<Queue>> m_queues;
+    std::vector<std::thread> m_threads;
+
+    std::atomic<size_t> m_next{ 0 };
+    // Tasks waiting in the deques, and tasks submitted but not finished yet.
+    std::atomic<size_t> m_queued{ 0 };
+    std::atomic<size_t> m_pending{ 0 };
+
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_done;
+    bool m_stop{ false };
+};
@@ -0,0 +1,73 @@
+#include "token_pipeline.h"
+
+namespace
+{
+    // Spins briefly, then gives the other side of the ring a chance to run.
+    void Backoff(unsigned& spins)
+    {
+        if (++spins > 64)
+            std::this_thread::yield();
+    }
+}
+
+TokenPipeline::TokenPipeline(std::string&& input, size_t capacity)
+    : m_input(std::move(input))
+    , m_ring(capacity)
+    , m_lexer(&TokenPipeline::Produce, this)
+{
+}
+
+TokenPipeline::~TokenPipeline()
+{
+    m_abandoned.store(true, std::memory_order_relaxed);
+    if (m_lexer.joinable())
+        m_lexer.join();
+}
+
+void TokenPipeline::Produce()
+{
+    TextTokenizer tokenizer(m_input);
+    try
+    {
+        while (auto token = tokenizer.Next())
+        {
+            std::optional<Token> slot = std::move(token);
+            for (unsigned spins = 0; !m_ring.TryPush(std::move(slot)); Backoff(spins))
+            {
+                if (m_abandoned.load(std::memory_order_relaxed))
+                    break;
+            }
+        }
+    }
+    catch (...)
+    {
+        m_error = std::current_exception();
+    }
+
+    for (unsigned spins = 0; !m_abandoned.load(std::memory_order_relaxed) && !m_ring.TryPush(std::nullopt); Backoff(spins))
+    {
+    }
+}
+
+std::optional<Token> TokenPipeline::Next()
+{
+    std::optional<Token> token;
+    for (unsigned spins = 0; !m_ring.TryPop(token); Backoff(spins))
+    {
+    }
+
+    if (!token && m_error)
+        std::rethrow_exception(m_error);
+
+    return token;
+}
+
+void TokenPipeline::Abandon()
+{
+    m_abandoned.store(true, std::memory_order_relaxed);
+    if (m_lexer.joinable())
+        m_lexer.join();
+
+    if (m_error)
+        std::rethrow_exception(m_error);
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <optional>
+#include <exception>
+
+#include "tokenizer.h"
+#include "spsc_ring.h"
+
+// Tokenizes a program on a thread of its own while the parser consumes the
+// tokens, handing them over through a lock-free ring. The end of the input is
+// an empty slot; a lexical error is kept and rethrown by Next once the tokens
+// before it have been consumed.
+class TokenPipeline
+{
+public:
+    explicit TokenPipeline(std::string&& input, size_t capacity = 1024);
+    ~TokenPipeline();
+
+    TokenPipeline(const TokenPipeline&) = delete;
+    TokenPipeline& operator=(const TokenPipeline&) = delete;
+
+    // The next token, or nothing at the end of the input. Consumer thread only.
+    std::optional<Token> Next();
+
+    // Stops taking tokens and lets the lexer run through the rest of the input
+    // without queueing them. Rethrows the lexical error if there was one, so
+    // that it wins over a syntax error as when tokenizing ahead of parsing.
+    void Abandon();
+
+private:
+    void Produce();
+
+    std::string m_input;
+    SpscRing<std::optional<Token>> m_ring;
+    // Published to the consumer by the end-of-input slot that follows it.
+    std::exception_ptr m_error;
+    std::atomic<bool> m_abandoned{ false };
+    std::thread m_lexer;
+};
@@ -1,51 +1,264 @@
-#include <regex>
+#include <array>
+#include <optional>
+#include <algorithm>
 #include <queue>
+#include <stdexcept>
 #include <string>
+#include <string_view>
 #include <utility>
 
 #include "tokenizer.h"
 
-using Token = std::pair<std::string, std::string>;
-
-std::queue<Token> Tokenize(std::string&& input)
+namespace
 {
-    std::regex id("[a-zA-Z0-9]+");
-    std::regex op(R"(\[|\]|=|;|\+|-|\*|\/|\(|\))");
-    std::regex empty("[ \t]+");
-    std::regex num("[0-9]+");
-    std::regex keyword("record|int|float");
+    // Token classes recognized by the lexer, in the same priority order
+    // the regex cascade used: keyword, num, id, operator, whitespace.
+    enum class TokenClass : uint8_t
+    {
+        None,
+        Keyword,
+        Num,
+        Id,
+        Operator,
+        Whitespace
+    };
+
+    constexpr std::string_view Keywords[] = { "record", "int", "float" };
+    constexpr std::string_view Operators = "[]=;+-*/()";
+    constexpr std::string_view Blanks = " \t";
+
+    using DfaState = uint8_t;
+
+    constexpr DfaState DeadState = 0;
+    constexpr DfaState StartState = 1;
+    constexpr DfaState NumState = 2;
+    constexpr DfaState IdState = 3;
+    constexpr DfaState OperatorState = 4;
+    constexpr DfaState WhitespaceState = 5;
+    constexpr DfaState FirstKeywordState = 6;
+    constexpr size_t MaxDfaStates = 32;
+
+    struct Dfa
+    {
+        std::array<std::array<DfaState, 256>, MaxDfaStates> next{};
+        std::array<TokenClass, MaxDfaStates> accepts{};
+        // The token ends as soon as one of these states is entered: keywords
+        // are matched as prefixes (as "record|int|float" was) and operators
+        // are single characters.
+        std::array<bool, MaxDfaStates> stop{};
+    };
+
+    constexpr bool IsDigit(char c)
+    {
+        return c >= '0' && c <= '9';
+    }
+
+    constexpr bool IsAlpha(char c)
+    {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+    }
 
-    std::queue<Token> tokens;
-    while (!input.empty())
+    constexpr Dfa BuildDfa()
     {
-        std::smatch match;
-        if (std::regex_search(input, match, keyword, std::regex_constants::match_continuous))
+        Dfa dfa;
+
+        for (size_t c = 0; c < 256; ++c)
         {
-            tokens.push({ match.str(), "" });
+            const char ch = static_cast<char>(c);
+
+            if (IsDigit(ch))
+            {
+                dfa.next[StartState][c] = NumState;
+                dfa.next[NumState][c] = NumState;
+            }
+
+            if (IsDigit(ch) || IsAlpha(ch))
+            {
+                dfa.next[IdState][c] = IdState;
+                if (IsAlpha(ch))
+                    dfa.next[StartState][c] = IdState;
+            }
+
+            if (Operators.find(ch) != std::string_view::npos)
+                dfa.next[StartState][c] = OperatorState;
+
+            if (Blanks.find(ch) != std::string_view::npos)
+            {
+                dfa.next[StartState][c] = WhitespaceState;
+                dfa.next[WhitespaceState][c] = WhitespaceState;
+            }
         }
-        else if (std::regex_search(input, match, num, std::regex_constants::match_continuous))
+
+        dfa.accepts[NumState] = TokenClass::Num;
+        dfa.accepts[IdState] = TokenClass::Id;
+        dfa.accepts[OperatorState] = TokenClass::Operator;
+        dfa.accepts[WhitespaceState] = TokenClass::Whitespace;
+        dfa.stop[OperatorState] = true;
+
+        // Keywords form a trie hanging off the start state. Every proper
+        // prefix is still a valid id, so trie nodes fall back to IdState.
+        DfaState freeState = FirstKeywordState;
+        for (const auto keyword : Keywords)
         {
-            tokens.push({ "num", match.str() });
+            DfaState state = StartState;
+            for (const char ch : keyword)
+            {
+                const auto c = static_cast<unsigned char>(ch);
+                DfaState next = dfa.next[state][c];
+                if (next == IdState || next == DeadState)
+                {
+                    next = freeState++;
+                    dfa.next[next] = dfa.next[IdState];
+                    dfa.accepts[next] = TokenClass::Id;
+                    dfa.next[state][c] = next;
+                }
+                state = next;
+            }
+            dfa.accepts[state] = TokenClass::Keyword;
+            dfa.stop[state] = true;
         }
-        else if (std::regex_search(input, match, id, std::regex_constants::match_continuous))
+
+        return dfa;
+    }
+
+    constexpr Dfa LexerDfa = BuildDfa();
+}
+
+namespace
+{
+    struct Lexeme
+    {
+        size_t end{ 0 };
+        TokenClass tokenClass{ TokenClass::None };
+    };
+
+    // Scans the lexeme that starts at pos. Returns false if it runs up to the
+    // end of text without being finished and more text may follow.
+    bool ScanLexeme(std::string_view text, size_t pos, bool last, Lexeme& lexeme)
+    {
+        DfaState state = StartState;
+        size_t end = pos;
+        while (true)
         {
-            tokens.push({ "id", match.str() });
+            if (end == text.size())
+            {
+                if (!last)
+                    return false;
+                break;
+            }
+
+            const DfaState next = LexerDfa.next[state][static_cast<unsigned char>(text[end])];
+            if (next == DeadState)
+                break;
+
+            state = next;
+            ++end;
+
+            if (LexerDfa.stop[state])
+                break;
         }
-        else if (std::regex_search(input, match, op, std::regex_constants::match_continuous))
+
+        lexeme = Lexeme{ end, LexerDfa.accepts[state] };
+        return true;
+    }
+
+    // The token for a lexeme, or nothing for whitespace.
+    std::optional<Token> MakeToken(std::string_view text, TokenClass tokenClass)
+    {
+        switch (tokenClass)
         {
-            tokens.push({ match.str(), "" });
+        case TokenClass::Keyword:
+        case TokenClass::Operator:
+            return Token{ text, "" };
+        case TokenClass::Num:
+            return Token{ "num", text };
+        case TokenClass::Id:
+            return Token{ "id", text };
+        case TokenClass::Whitespace:
+            return std::nullopt;
+        case TokenClass::None:
+            break;
         }
-        else
+        throw std::runtime_error("Lexical error: permitted characters found.");
+    }
+}
+
+TextTokenizer::TextTokenizer(std::string_view text)
+    : m_text(text)
+{
+}
+
+std::optional<Token> TextTokenizer::Next()
+{
+    while (m_pos < m_text.size())
+    {
+        Lexeme lexeme;
+        ScanLexeme(m_text, m_pos, true, lexeme);
+
+        const std::string_view text = m_text.substr(m_pos, lexeme.end - m_pos);
+        m_pos = lexeme.end;
+
+        if (auto token = MakeToken(text, lexeme.tokenClass))
+            return token;
+    }
+
+    return std::nullopt;
+}
+
+TokenQueue Tokenize(std::string&& input)
+{
+    TextTokenizer tokenizer(input);
+
+    TokenQueue tokens{ std::pmr::deque<Token>(CurrentMemoryResource()) };
+    while (auto token = tokenizer.Next())
+        tokens.push(std::move(*token));
+
+    return tokens;
+}
+
+StreamTokenizer::StreamTokenizer(std::istream& input, size_t chunkSize)
+    : m_input(input)
+    , m_chunkSize(std::max<size_t>(chunkSize, 1))
+{
+}
+
+std::optional<Token> StreamTokenizer::Next()
+{
+    while (true)
+    {
+        if (m_pos == m_buffer.size() && !Refill())
+            return std::nullopt;
+
+        Lexeme lexeme;
+        if (!ScanLexeme(m_buffer, m_pos, m_end, lexeme))
         {
-            std::regex_search(input, match, empty, std::regex_constants::match_continuous);
+            Refill();
+            continue;
         }
 
-        if (match.empty())
-            throw std::runtime_error("Lexical error: permitted characters found.");
+        const std::string_view text = std::string_view{ m_buffer }.substr(m_pos, lexeme.end - m_pos);
+        m_pos = lexeme.end;
 
-        input = input.substr(match.str().size());
-        continue;
+        if (auto token = MakeToken(text, lexeme.tokenClass))
+            return token;
     }
+}
 
-    return tokens;
-}
\ No newline at end of file
+bool StreamTokenizer::Refill()
+{
+    if (m_end)
+        return false;
+
+    m_buffer.erase(0, m_pos);
+    m_pos = 0;
+
+    const size_t size = m_buffer.size();
+    m_buffer.resize(size + m_chunkSize);
+    m_input.read(m_buffer.data() + size, static_cast<std::streamsize>(m_chunkSize));
+    m_buffer.resize(size + static_cast<size_t>(m_input.gcount()));
+
+    if (m_buffer.size() == size)
+        m_end = true;
+
+    return !m_end;
+}
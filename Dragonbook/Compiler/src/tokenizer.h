@@ -1,8 +1,54 @@
 #pragma once
+#include <deque>
 #include <queue>
+#include <memory_resource>
 #include <string>
+#include <istream>
 #include <utility>
+#include <string_view>
+#include <optional>
+
+#include "memory_arena.h"
 
 using Token = std::pair<std::string, std::string>;
+using TokenQueue = std::queue<Token, std::pmr::deque<Token>>;
+
+// The queue allocates from CurrentMemoryResource.
+TokenQueue Tokenize(std::string&& input);
+
+// Tokenizes text lazily, one token per call. The text must outlive the
+// tokenizer.
+class TextTokenizer
+{
+public:
+    explicit TextTokenizer(std::string_view text);
+
+    // The next token, or nothing at the end of the text.
+    std::optional<Token> Next();
+
+private:
+    std::string_view m_text;
+    size_t m_pos{ 0 };
+};
+
+// Tokenizes a stream lazily, reading it in chunks as tokens are asked for. A
+// lexeme cut by the end of a chunk is finished with the next one, so the
+// buffer holds at most one chunk and the rest of the current lexeme.
+class StreamTokenizer
+{
+public:
+    explicit StreamTokenizer(std::istream& input, size_t chunkSize = 64 * 1024);
+
+    // The next token, or nothing at the end of the input.
+    std::optional<Token> Next();
+
+private:
+    // Reads one more chunk. Returns false at the end of the input.
+    bool Refill();
 
-std::queue<Token> Tokenize(std::string&& input);
+    std::istream& m_input;
+    size_t m_chunkSize;
+    std::string m_buffer;
+    size_t m_pos{ 0 };
+    bool m_end{ false };
+};
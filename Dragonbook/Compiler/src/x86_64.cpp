@@ -0,0 +1,230 @@
+#include <limits>
+#include <stdexcept>
+
+#include <compiler/x86_64.h>
+#include <compiler/memory_layout.h>
+
+namespace
+{
+    size_t AlignUp(size_t value, size_t alignment)
+    {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    bool FitsImmediate(int64_t value)
+    {
+        return value >= std::numeric_limits<int32_t>::min() && value <= std::numeric_limits<int32_t>::max();
+    }
+
+    // Frame of the generated function, from the frame pointer down:
+    //
+    //     -8(%rbp)            saved memory argument
+    //     ...                 temporaries, see AllocateStorage
+    //     -frameSize(%rbp)    variables, as in the memory image
+    class Emitter
+    {
+    public:
+        Emitter(const ThreeAddressCode& code, const AssemblyOptions& options)
+            : m_code(code)
+            , m_options(options)
+            , m_layout(AllocateStorage(code))
+        {
+            m_variablesSize = AlignUp(m_layout.data.size, 8);
+            m_frameSize = AlignUp(m_variablesSize + m_layout.frame.size + 8, 16);
+
+            if (m_frameSize > static_cast<size_t>(std::numeric_limits<int32_t>::max()))
+                throw std::runtime_error("Stack frame is too large: " + std::to_string(m_frameSize) + " bytes");
+        }
+
+        std::string Generate()
+        {
+            const std::string& name = m_options.function;
+
+            Line("    .text");
+            Line("    .globl " + name);
+            Line("    .type " + name + ", @function");
+            Line(name + ":");
+            Line("    pushq %rbp");
+            Line("    movq %rsp, %rbp");
+            Line("    subq $" + std::to_string(m_frameSize) + ", %rsp");
+            Line("    movq %rdi, -8(%rbp)");
+            Line("    leaq " + Frame(0) + ", %rdi");
+            Line("    movq $" + std::to_string(m_variablesSize) + ", %rcx");
+            Line("    xorl %eax, %eax");
+            Line("    rep stosb");
+
+            for (const Quad& quad : m_code.quads)
+                Emit(quad);
+
+            Line("    movq -8(%rbp), %rdi");
+            Line("    testq %rdi, %rdi");
+            Line("    je .L" + name + "_return");
+            Line("    leaq " + Frame(0) + ", %rsi");
+            Line("    movq $" + std::to_string(m_variablesSize) + ", %rcx");
+            Line("    rep movsb");
+            Line(".L" + name + "_return:");
+            Line("    leave");
+            Line("    ret");
+            Line("    .size " + name + ", .-" + name);
+            Line("    .section .note.GNU-stack,\"\",@progbits");
+
+            return std::move(m_text);
+        }
+
+    private:
+        void Line(const std::string& line)
+        {
+            m_text += line;
+            m_text += '\n';
+        }
+
+        // Address of a byte in the frame, counted from its bottom.
+        std::string Frame(size_t offset, const std::string& index = {}) const
+        {
+            const auto displacement = static_cast<int64_t>(offset) - static_cast<int64_t>(m_frameSize);
+            return std::to_string(displacement) + "(%rbp" + (index.empty() ? "" : ", " + index) + ")";
+        }
+
+        size_t VariableOffset(const Operand& operand) const
+        {
+            return m_layout.data.offsets[operand.id];
+        }
+
+        const IrVariable& Array(const Operand& operand) const
+        {
+            if (operand.kind != Operand::Kind::Variable || !IsArray(m_code.variables[operand.id]))
+                throw std::runtime_error("Array expected: " + OperandName(m_code, operand));
+            return m_code.variables[operand.id];
+        }
+
+        // Operand as an instruction source: an immediate or a memory location,
+        // or empty for constants that need movabs.
+        std::string Source(const Operand& operand) const
+        {
+            switch (operand.kind)
+            {
+            case Operand::Kind::Variable:
+                return Frame(VariableOffset(operand));
+            case Operand::Kind::Temp:
+                return Frame(m_variablesSize + m_layout.frame.offsets[operand.id]);
+            case Operand::Kind::Constant:
+            {
+                const int64_t value = ConstantValue(m_code.constants[operand.id]);
+                return FitsImmediate(value) ? "$" + std::to_string(value) : std::string{};
+            }
+            case Operand::Kind::None:
+                break;
+            }
+            throw std::logic_error("Operand has no location");
+        }
+
+        bool IsFloatScalar(const Operand& operand) const
+        {
+            return operand.kind == Operand::Kind::Variable && IsFloat(m_code.variables[operand.id]);
+        }
+
+        void Load(const Operand& operand, const std::string& reg)
+        {
+            const std::string source = Source(operand);
+            if (IsFloatScalar(operand))
+                Line("    cvttss2siq " + source + ", " + reg);
+            else if (source.empty())
+                Line("    movabsq $" + std::to_string(ConstantValue(m_code.constants[operand.id])) + ", " + reg);
+            else
+                Line("    movq " + source + ", " + reg);
+        }
+
+        // Operand usable directly by an arithmetic instruction, going through
+        // %rcx for 64-bit immediates.
+        std::string Argument(const Operand& operand)
+        {
+            const std::string source = Source(operand);
+            if (!source.empty() && !IsFloatScalar(operand))
+                return source;
+
+            Load(operand, "%rcx");
+            return "%rcx";
+        }
+
+        void Emit(const Quad& quad)
+        {
+            switch (quad.op)
+            {
+            case OpCode::Add:
+            case OpCode::Sub:
+            case OpCode::Mul:
+            {
+                Load(quad.arg1, "%rax");
+                const std::string rhs = Argument(quad.arg2);
+                const char* instruction = quad.op == OpCode::Add ? "addq" : quad.op == OpCode::Sub ? "subq" : "imulq";
+                Line("    " + std::string{ instruction } + " " + rhs + ", %rax");
+                break;
+            }
+            case OpCode::Div:
+                Load(quad.arg1, "%rax");
+                Load(quad.arg2, "%rcx");
+                Line("    cqto");
+                Line("    idivq %rcx");
+                break;
+            case OpCode::Copy:
+                Load(quad.arg1, "%rax");
+                break;
+            case OpCode::Load:
+                Load(quad.arg2, "%rcx");
+                if (IsFloat(Array(quad.arg1)))
+                    Line("    cvttss2siq " + Frame(VariableOffset(quad.arg1), "%rcx") + ", %rax");
+                else
+                    Line("    movq " + Frame(VariableOffset(quad.arg1), "%rcx") + ", %rax");
+                break;
+            case OpCode::Address:
+                Array(quad.arg1);
+                Load(quad.arg2, "%rcx");
+                Line("    leaq " + Frame(VariableOffset(quad.arg1), "%rcx") + ", %rax");
+                if (quad.result.kind == Operand::Kind::Temp)
+                {
+                    if (m_floatAddress.size() <= quad.result.id)
+                        m_floatAddress.resize(quad.result.id + 1);
+                    m_floatAddress[quad.result.id] = IsFloat(m_code.variables[quad.arg1.id]);
+                }
+                break;
+            case OpCode::Store:
+                Load(quad.result, "%rax");
+                Load(quad.arg1, "%rcx");
+                if (quad.result.kind == Operand::Kind::Temp && quad.result.id < m_floatAddress.size() && m_floatAddress[quad.result.id])
+                {
+                    Line("    cvtsi2ssq %rcx, %xmm0");
+                    Line("    movss %xmm0, (%rax)");
+                }
+                else
+                {
+                    Line("    movq %rcx, (%rax)");
+                }
+                return;
+            }
+
+            if (IsFloatScalar(quad.result))
+            {
+                Line("    cvtsi2ssq %rax, %xmm0");
+                Line("    movss %xmm0, " + Source(quad.result));
+            }
+            else
+            {
+                Line("    movq %rax, " + Source(quad.result));
+            }
+        }
+
+        const ThreeAddressCode& m_code;
+        const AssemblyOptions& m_options;
+        StorageLayout m_layout;
+        size_t m_variablesSize{ 0 };
+        size_t m_frameSize{ 0 };
+        // Whether the address held by a temporary points to a float element.
+        std::vector<bool> m_floatAddress;
+        std::string m_text;
+    };
+}
+
+std::string GenerateAssembly(const ThreeAddressCode& code, const AssemblyOptions& options)
+{
+    return Emitter{ code, options }.Generate();
+}
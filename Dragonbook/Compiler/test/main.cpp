@@ -1,7 +1,86 @@
 #define BOOST_TEST_MODULE compiler_tests tests
 #include <boost/test/included/unit_test.hpp>
 
+#include <new>
+#include <set>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <random>
+#include <functional>
+#include <fstream>
+#include <sstream>
+
 #include <compiler/compiler.h>
+#include <compiler/interpreter.h>
+#include <compiler/x86_64.h>
+#include <compiler/incremental_compiler.h>
+#include "grammar_cache.h"
+#include "grammar_tables.h"
+#include "semantic_actions.h"
+#include "program_chunks.h"
+
+namespace
+{
+    // Heap allocations made by this thread while counting is on, see
+    // CompileArenaTest.
+    thread_local bool countHeapAllocations = false;
+    thread_local size_t heapAllocations = 0;
+
+    template<typename Function>
+    size_t HeapAllocationsOf(Function&& function)
+    {
+        heapAllocations = 0;
+        countHeapAllocations = true;
+        function();
+        countHeapAllocations = false;
+        return heapAllocations;
+    }
+}
+
+void* operator new(std::size_t size)
+{
+    if (countHeapAllocations)
+        ++heapAllocations;
+
+    if (void* p = std::malloc(size != 0 ? size : 1))
+        return p;
+
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+// std::pmr::new_delete_resource allocates with explicit alignment.
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+    if (countHeapAllocations)
+        ++heapAllocations;
+
+    const auto align = static_cast<std::size_t>(alignment);
+    if (void* p = std::aligned_alloc(align, (std::max<std::size_t>(size, 1) + align - 1) / align * align))
+        return p;
+
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p, std::align_val_t) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept
+{
+    std::free(p);
+}
 
 BOOST_AUTO_TEST_CASE(ArraysTest)
 {
@@ -89,3 +168,992 @@ BOOST_AUTO_TEST_CASE(SmokeTest)
 
     BOOST_TEST(threeAddressCode.c_str() == expectedCode.c_str());
 }
+
+BOOST_AUTO_TEST_CASE(LexerTest)
+{
+    std::string input =
+        "int\tvar1 = 12 +\t3;"
+        "var1 = (var1-2)/3;"
+    ;
+
+    const std::string expectedCode =
+        "t0 = 12 + 3\n"
+        "var1 = t0\n"
+        "t1 = var1 - 2\n"
+        "t2 = t1 / 3\n"
+        "var1 = t2\n";
+
+    const std::string threeAddressCode = Compile("grammar.csv", std::move(input));
+
+    BOOST_TEST(threeAddressCode.c_str() == expectedCode.c_str());
+    BOOST_CHECK_THROW(Compile("grammar.csv", "int a = 1 # 2;"), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(GrammarCacheTest)
+{
+    const auto dir = std::filesystem::temp_directory_path() / "dragonbook-grammar-cache-test";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    std::filesystem::copy_file("grammar.csv", dir / "grammar.csv");
+
+    const LalrTable parsed = LoadGrammar(dir / "grammar.csv", dir / "cache");
+    BOOST_TEST(std::distance(std::filesystem::directory_iterator(dir / "cache"), std::filesystem::directory_iterator{}) == 1);
+
+    const LalrTable mapped = LoadGrammar(dir / "grammar.csv", dir / "cache");
+    BOOST_TEST(mapped.SourceHash() == parsed.SourceHash());
+    BOOST_TEST(std::equal(mapped.Image().begin(), mapped.Image().end(), parsed.Image().begin(), parsed.Image().end()));
+
+    // An image with a matching hash but an out-of-range shift target is
+    // rejected and rebuilt from the CSV.
+    auto corrupted = std::make_shared<std::vector<std::byte>>(parsed.Image().begin(), parsed.Image().end());
+    {
+        const auto& header = *reinterpret_cast<const TableImageHeader*>(corrupted->data());
+        auto* actions = reinterpret_cast<Action*>(corrupted->data() + header.actionsOffset);
+        auto* shift = std::find_if(actions, actions + header.statesCount * header.symbolsCount,
+            [](const Action& a) { return a.type == Action::Type::Shift; });
+        shift->value = static_cast<uint16_t>(header.statesCount);
+    }
+    const std::span<const std::byte> corruptedImage{ corrupted->data(), corrupted->size() };
+    BOOST_CHECK_THROW(LalrTable(corrupted, corruptedImage), std::runtime_error);
+
+    const auto cacheFile = std::filesystem::directory_iterator(dir / "cache")->path();
+    std::ofstream(cacheFile, std::ios::binary | std::ios::trunc).write(
+        reinterpret_cast<const char*>(corrupted->data()), static_cast<std::streamsize>(corrupted->size()));
+    const LalrTable repaired = LoadGrammar(dir / "grammar.csv", dir / "cache");
+    BOOST_TEST(std::equal(repaired.Image().begin(), repaired.Image().end(), parsed.Image().begin(), parsed.Image().end()));
+    BOOST_TEST(LoadGrammar(dir / "grammar.csv", dir / "cache").StatesCount() == parsed.StatesCount());
+
+    // Any change of the CSV produces a new cache entry.
+    std::ofstream(dir / "grammar.csv", std::ios::app) << "\n";
+    const LalrTable rebuilt = LoadGrammar(dir / "grammar.csv", dir / "cache");
+    BOOST_TEST(rebuilt.SourceHash() != parsed.SourceHash());
+    BOOST_TEST(rebuilt.StatesCount() == parsed.StatesCount());
+    BOOST_TEST(std::distance(std::filesystem::directory_iterator(dir / "cache"), std::filesystem::directory_iterator{}) == 2);
+
+    std::filesystem::remove_all(dir);
+
+    const auto defaultDirectory = DefaultGrammarCacheDirectory();
+    if (!defaultDirectory.empty())
+    {
+        const auto permissions = std::filesystem::status(defaultDirectory).permissions();
+        BOOST_TEST(((permissions & (std::filesystem::perms::group_write | std::filesystem::perms::others_write)) == std::filesystem::perms::none));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(BuiltinGrammarTest)
+{
+    const LalrTable table = ParseGrammarFile("grammar.csv");
+    BOOST_TEST(BuiltinGrammar::SourceHash() == table.SourceHash());
+    BOOST_TEST(BuiltinGrammar::StatesCount() == table.StatesCount());
+    BOOST_TEST(BuiltinGrammar::SymbolsCount() == table.SymbolsCount());
+    BOOST_TEST(BuiltinGrammar::ProductionsCount() == table.ProductionsCount());
+
+    for (State s = 0; s < table.StatesCount(); ++s)
+    {
+        for (SymbolId i = 0; i < table.SymbolsCount(); ++i)
+        {
+            BOOST_TEST((BuiltinGrammar::At(s, i).type == table.At(s, i).type));
+            BOOST_TEST(BuiltinGrammar::At(s, i).value == table.At(s, i).value);
+        }
+    }
+
+    static_assert(BuiltinGrammar::FindTerminal("id").has_value());
+    static_assert(!BuiltinGrammar::FindTerminal("record").has_value());
+
+    std::string input =
+        "int[3][2] b;"
+        "int c = 4;"
+        "b[2][1] = -(c + 1) / 2;"
+    ;
+
+    BOOST_TEST(Compile(std::string(input)) == Compile("grammar.csv", std::string(input)));
+}
+
+BOOST_AUTO_TEST_CASE(ConcurrentCompilerTest)
+{
+    const std::string input =
+        "int[4][3][2] d;"
+        "int x = 2;"
+        "d[x][1][0] = x * 3 + 1;"
+        "x = d[2][1][0] - x;"
+    ;
+
+    const Compiler compilers[] = { Compiler{}, Compiler{ "grammar.csv" } };
+    for (const Compiler& compiler : compilers)
+    {
+        const std::string expectedCode = compiler.Compile(std::string(input));
+
+        std::vector<size_t> mismatches(8);
+        {
+            std::vector<std::thread> threads;
+            for (size_t i = 0; i < mismatches.size(); ++i)
+            {
+                threads.emplace_back([&compiler, &input, &expectedCode, &count = mismatches[i]]() {
+                    for (int n = 0; n < 100; ++n)
+                    {
+                        if (compiler.Compile(std::string(input)) != expectedCode)
+                            count++;
+                    }
+                });
+            }
+
+            for (auto& t : threads)
+                t.join();
+        }
+
+        for (const auto count : mismatches)
+            BOOST_TEST(count == 0);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(SemanticActionsBindingTest)
+{
+    const auto dir = std::filesystem::temp_directory_path() / "dragonbook-semantic-actions-test";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+
+    // The same grammar with one more production that has no semantic action.
+    {
+        std::ifstream in("grammar.csv");
+        std::ofstream out(dir / "grammar.csv");
+        std::string line;
+        for (size_t n = 0; std::getline(in, line); ++n)
+        {
+            // The first empty line after the header ends the production list.
+            if (n > 1 && line.empty() && in)
+            {
+                out << "Expr -> Expr Expr\n" << line << "\n";
+                break;
+            }
+            out << line << "\n";
+        }
+        out << in.rdbuf();
+    }
+
+    BOOST_CHECK_THROW(Compiler{ dir / "grammar.csv" }, std::runtime_error);
+    BOOST_CHECK_NO_THROW(Compiler{ "grammar.csv" });
+
+    std::filesystem::remove_all(dir);
+}
+
+BOOST_AUTO_TEST_CASE(LongProgramTest)
+{
+    const size_t statements = 20000;
+
+    std::string input = "int x = 0;";
+    std::string expectedCode = "x = 0\n";
+    for (size_t i = 0; i < statements; ++i)
+    {
+        input += "x = x + 1;";
+        expectedCode += "t" + std::to_string(i) + " = x + 1\n";
+        expectedCode += "x = t" + std::to_string(i) + "\n";
+    }
+
+    BOOST_TEST(Compile(std::move(input)) == expectedCode);
+}
+
+BOOST_AUTO_TEST_CASE(ThreeAddressCodeTest)
+{
+    const ThreeAddressCode code = Compiler{}.CompileToIr(
+        "int[2] a;"
+        "int i = 1;"
+        "a[i] = i * 3;"
+    );
+
+    const Operand a{ Operand::Kind::Variable, 0 };
+    const Operand i{ Operand::Kind::Variable, 1 };
+    const auto temp = [](uint32_t id) { return Operand{ Operand::Kind::Temp, id }; };
+    const auto constant = [](uint32_t id) { return Operand{ Operand::Kind::Constant, id }; };
+
+    const std::vector<Quad> expectedQuads = {
+        { OpCode::Copy, i, constant(0) },
+        { OpCode::Mul, temp(0), i, constant(1) },
+        { OpCode::Mul, temp(1), i, constant(2) },
+        { OpCode::Address, temp(2), a, temp(1) },
+        { OpCode::Store, temp(2), temp(0) },
+    };
+    BOOST_TEST((code.quads == expectedQuads));
+
+    BOOST_TEST(code.variables.size() == 2);
+    BOOST_TEST(code.variables[0].name == "a");
+    BOOST_TEST(code.variables[0].type == "int[]");
+    BOOST_TEST(code.variables[0].size == 16);
+    BOOST_TEST(code.variables[1].name == "i");
+    BOOST_TEST(code.temps.size() == 3);
+    BOOST_TEST(ConstantValue(code.constants[2]) == 8);
+
+    BOOST_TEST(PrintThreeAddressCode(code) ==
+        "i = 1\n"
+        "t0 = i * 3\n"
+        "t1 = i * 8\n"
+        "t2 = a + t1\n"
+        "*t2 = t0\n");
+
+    // A literal beyond 64 bits is printed as written; only evaluating it fails.
+    const ThreeAddressCode large = Compiler{}.CompileToIr("int a; a = 99999999999999999999;");
+    BOOST_TEST(PrintThreeAddressCode(large) == "a = 99999999999999999999\n");
+    BOOST_TEST(!large.constants[0].value.has_value());
+    BOOST_CHECK_THROW(Execute(large), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(FoldConstantsTest)
+{
+    CompileOptions options;
+    options.foldConstants = true;
+
+    std::string input =
+        "int a = 1 + 1 * 2;"
+        "int[3][2] b;"
+        "b[0][1] = 3;"
+        "b[2][1] = 7;"
+        "int c;"
+        "c = b[0][0] + a;"
+        "int[4][3][2] d;"
+        "d[3][1][0] = 17;"
+        "d[a][1][c] = d[1][a][1] * 1 + -(2 * 3);"
+    ;
+
+    const std::string expectedCode =
+        "a = 3\n"
+        "t0 = b + 8\n"
+        "*t0 = 3\n"
+        "t1 = b + 40\n"
+        "*t1 = 7\n"
+        "t2 = b[0]\n"
+        "t3 = t2 + a\n"
+        "c = t3\n"
+        "t4 = d + 160\n"
+        "*t4 = 17\n"
+        "t5 = a * 16\n"
+        "t6 = t5 + 56\n"
+        "t7 = d[t6]\n"
+        "t8 = t7 * -5\n"
+        "t9 = a * 6\n"
+        "t10 = t9 + c\n"
+        "t11 = t10 * 8\n"
+        "t12 = t11 + 16\n"
+        "t13 = d + t12\n"
+        "*t13 = t8\n";
+
+    const std::string threeAddressCode = Compiler{}.Compile(std::move(input), options);
+
+    BOOST_TEST(threeAddressCode.c_str() == expectedCode.c_str());
+
+    // An inner dimension of 0 makes every offset 0.
+    BOOST_TEST(Compiler{}.Compile("int[2][3][0] a; a[1][1][0] = 1;", options) == "t0 = a + 0\n*t0 = 1\n");
+}
+
+BOOST_AUTO_TEST_CASE(CommonSubexpressionsTest)
+{
+    CompileOptions options;
+    options.eliminateCommonSubexpressions = true;
+
+    std::string input =
+        "int i = 1;"
+        "int j = 2;"
+        "int x;"
+        "int[4][4] a;"
+        "int[4][4] b;"
+        "b[i][j] = a[i][j] + a[i][j];"
+        "x = a[i][j];"
+        "b[j][i] = x * i + i * x;"
+        "a[i][j] = 3;"
+        "x = a[i][j];"
+    ;
+
+    const std::string expectedCode =
+        "i = 1\n"
+        "j = 2\n"
+        "t0 = i * 32\n"
+        "t1 = j * 8\n"
+        "t2 = t0 + t1\n"
+        "t3 = a[t2]\n"
+        "t8 = t3 + t3\n"
+        "t12 = b + t2\n"
+        "*t12 = t8\n"
+        "x = t3\n"
+        "t17 = i * x\n"
+        "t18 = i + t17\n"
+        "t19 = x * t18\n"
+        "t20 = j * 32\n"
+        "t21 = i * 8\n"
+        "t22 = t20 + t21\n"
+        "t23 = b + t22\n"
+        "*t23 = t19\n"
+        "t27 = a + t2\n"
+        "*t27 = 3\n"
+        "t31 = a[t2]\n"
+        "x = t31\n";
+
+    CompileReport report;
+    const std::string threeAddressCode = Compiler{}.Compile(std::move(input), options, &report);
+
+    BOOST_TEST(threeAddressCode.c_str() == expectedCode.c_str());
+    BOOST_TEST(report.eliminatedSubexpressions == 17u);
+}
+
+BOOST_AUTO_TEST_CASE(PropagateCopiesTest)
+{
+    CompileOptions options;
+    options.propagateCopies = true;
+
+    std::string input =
+        "int i = 1;"
+        "int x = i + 2;"
+        "int[4] a;"
+        "int y;"
+        "y = x;"
+        "a[y] = (x) * y;"
+        "i = 3;"
+        "x = a[i] + i;"
+        "y = 0;"
+    ;
+
+    const std::string expectedCode =
+        "x = 1 + 2\n"
+        "t0 = x * x\n"
+        "t1 = x * 8\n"
+        "t2 = a + t1\n"
+        "*t2 = t0\n"
+        "i = 3\n"
+        "t3 = 3 * 8\n"
+        "t4 = a[t3]\n"
+        "x = t4 + 3\n"
+        "y = 0\n";
+
+    CompileReport report;
+    const ThreeAddressCode code = Compiler{}.CompileToIr(std::move(input), options, &report);
+
+    BOOST_TEST(PrintThreeAddressCode(code).c_str() == expectedCode.c_str());
+    BOOST_TEST(code.temps.size() == 5u);
+    BOOST_TEST(report.coalescedCopies == 2u);
+    BOOST_TEST(report.removedDeadCode == 2u);
+}
+
+BOOST_AUTO_TEST_CASE(RegisterAllocationTest)
+{
+    CompileOptions options;
+    options.registers = 2;
+
+    std::string input =
+        "int[4][3][2] d;"
+        "int a;"
+        "int c;"
+        "d[a][1][c] = d[1][a][1] * 1 + -(2 * 3);"
+    ;
+
+    const std::string expectedCode =
+        "t0 = 1 * 48\n"
+        "t1 = a * 16\n"
+        "t2 = 1 * 8\n"
+        "t0 = t0 + t1\n"
+        "t0 = t0 + t2\n"
+        "t0 = d[t0]\n"
+        "t1 = 2 * 3\n"
+        "t1 = 0 - t1\n"
+        "t1 = 1 + t1\n"
+        "t2 = t0 * t1\n"
+        "t1 = a * 48\n"
+        "t0 = 1 * 16\n"
+        "t3 = c * 8\n"
+        "t0 = t1 + t0\n"
+        "t0 = t0 + t3\n"
+        "t0 = d + t0\n"
+        "*t0 = t2\n";
+
+    CompileReport report;
+    const ThreeAddressCode code = Compiler{}.CompileToIr(std::move(input), options, &report);
+
+    BOOST_TEST(PrintThreeAddressCode(code).c_str() == expectedCode.c_str());
+    BOOST_TEST(report.registersUsed == 2u);
+    BOOST_TEST(report.spillSlots == 2u);
+    BOOST_TEST(code.temps.size() == 4u);
+}
+
+BOOST_AUTO_TEST_CASE(RegisterAllocationSpillTest)
+{
+    // Random programs whose common subexpressions stay live across many
+    // statements, so that a handful of registers forces evictions.
+    std::mt19937 random(7);
+    const auto pick = [&random](size_t count) { return std::to_string(random() % count); };
+
+    std::function<std::string(int)> expression = [&](int depth) -> std::string
+    {
+        switch (random() % (depth > 2 ? 3 : 6))
+        {
+        case 0: return "v" + pick(3);
+        case 1: return "a[" + pick(4) + "]";
+        case 2: return pick(5);
+        default: break;
+        }
+
+        const std::string op = std::string(1, "+-*"[random() % 3]);
+        return "(" + expression(depth + 1) + " " + op + " " + expression(depth + 1) + ")";
+    };
+
+    CompileOptions reference;
+    reference.eliminateCommonSubexpressions = true;
+
+    for (int program = 0; program < 200; ++program)
+    {
+        std::string input = "int[4] a; int v0 = 1; int v1 = 2; int v2 = 3;";
+        for (int statement = 0; statement < 6; ++statement)
+        {
+            const std::string e = expression(0);
+            input += random() % 2
+                ? "v" + pick(3) + " = " + e + " + " + e + ";"
+                : "a[" + pick(4) + "] = " + e + " * " + e + ";";
+        }
+
+        const ExecutionResult expected = Execute(Compiler{}.CompileToIr(std::string(input), reference));
+        for (size_t registers : { 1u, 2u })
+        {
+            CompileOptions options = reference;
+            options.registers = registers;
+
+            const ExecutionResult actual = Execute(Compiler{}.CompileToIr(std::string(input), options));
+            BOOST_TEST(actual.memory == expected.memory, input << " with " << registers << " registers");
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(InterpreterTest)
+{
+    const std::string input =
+        "int[3][2] b;"
+        "float[4] f;"
+        "int a = 2;"
+        "b[a][1] = a * 3;"
+        "int c;"
+        "c = b[2][1] + 1 - 10 / a;"
+        "f[a + 1] = c * 2;"
+        "x = f[3] / (0 - a);"
+    ;
+
+    CompileOptions optimized;
+    optimized.eliminateCommonSubexpressions = true;
+    optimized.propagateCopies = true;
+    optimized.registers = 2;
+
+    for (const auto& options : { CompileOptions{}, optimized })
+    {
+        const ExecutionResult result = Execute(Compiler{}.CompileToIr(std::string{ input }, options));
+
+        BOOST_TEST(result.Value("a") == 2);
+        BOOST_TEST(result.Value("b", 40) == 6);
+        BOOST_TEST(result.Value("b", 32) == 0);
+        BOOST_TEST(result.Value("c") == 2);
+        BOOST_TEST(result.Value("f", 12) == 4);
+        BOOST_TEST(result.Value("x") == -2);
+        BOOST_TEST(result.memory.size() == 88u);
+    }
+
+    BOOST_CHECK_THROW(Execute(Compiler{}.CompileToIr("int a; x = 1 / a;")), std::runtime_error);
+    BOOST_CHECK_THROW(Execute(Compiler{}.CompileToIr("int[2] a; a[2] = 1;")), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(X86_64BackendTest)
+{
+    const ThreeAddressCode code = Compiler{}.CompileToIr("int[2] a; int i = 1; a[i] = i * 3 + 5000000000;");
+
+    const std::string expectedAssembly =
+        "    .text\n"
+        "    .globl dragonbook_program\n"
+        "    .type dragonbook_program, @function\n"
+        "dragonbook_program:\n"
+        "    pushq %rbp\n"
+        "    movq %rsp, %rbp\n"
+        "    subq $64, %rsp\n"
+        "    movq %rdi, -8(%rbp)\n"
+        "    leaq -64(%rbp), %rdi\n"
+        "    movq $24, %rcx\n"
+        "    xorl %eax, %eax\n"
+        "    rep stosb\n"
+        "    movq $1, %rax\n"
+        "    movq %rax, -64(%rbp)\n"
+        "    movq $3, %rax\n"
+        "    movabsq $5000000000, %rcx\n"
+        "    addq %rcx, %rax\n"
+        "    movq %rax, -40(%rbp)\n"
+        "    movq -64(%rbp), %rax\n"
+        "    imulq -40(%rbp), %rax\n"
+        "    movq %rax, -32(%rbp)\n"
+        "    movq -64(%rbp), %rax\n"
+        "    imulq $8, %rax\n"
+        "    movq %rax, -24(%rbp)\n"
+        "    movq -24(%rbp), %rcx\n"
+        "    leaq -56(%rbp, %rcx), %rax\n"
+        "    movq %rax, -16(%rbp)\n"
+        "    movq -16(%rbp), %rax\n"
+        "    movq -32(%rbp), %rcx\n"
+        "    movq %rcx, (%rax)\n"
+        "    movq -8(%rbp), %rdi\n"
+        "    testq %rdi, %rdi\n"
+        "    je .Ldragonbook_program_return\n"
+        "    leaq -64(%rbp), %rsi\n"
+        "    movq $24, %rcx\n"
+        "    rep movsb\n"
+        ".Ldragonbook_program_return:\n"
+        "    leave\n"
+        "    ret\n"
+        "    .size dragonbook_program, .-dragonbook_program\n"
+        "    .section .note.GNU-stack,\"\",@progbits\n";
+
+    BOOST_TEST(GenerateAssembly(code).c_str() == expectedAssembly.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(X86_64ExecutionTest)
+{
+#if !defined(__x86_64__) || !defined(__linux__)
+    BOOST_TEST_MESSAGE("Skipped: the generated code runs only on x86-64 Linux");
+#else
+    if (std::system("cc --version > /dev/null 2>&1") != 0)
+    {
+        BOOST_TEST_MESSAGE("Skipped: no C compiler to assemble the generated code");
+        return;
+    }
+
+    const auto dir = std::filesystem::temp_directory_path() / "dragonbook-x86_64-test";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+
+    // Runs the program on a zeroed image of the given size and writes the
+    // image to a file.
+    std::ofstream(dir / "main.c") <<
+        "#include <stdio.h>\n"
+        "#include <stdlib.h>\n"
+        "void dragonbook_program(void* memory);\n"
+        "int main(int argc, char** argv)\n"
+        "{\n"
+        "    size_t size = strtoul(argv[1], 0, 10);\n"
+        "    unsigned char* memory = calloc(size + 1, 1);\n"
+        "    dragonbook_program(memory);\n"
+        "    FILE* f = fopen(argv[2], \"wb\");\n"
+        "    return !f || fwrite(memory, 1, size, f) != size || fclose(f) != 0;\n"
+        "}\n";
+
+    const std::string input =
+        "int[3][2] b;"
+        "float[4] f;"
+        "int a = 2;"
+        "b[a][1] = a * 3;"
+        "int c;"
+        "c = b[2][1] + 1 - 10 / a;"
+        "f[a + 1] = c * 2;"
+        "x = f[3] / (0 - a);"
+        "int[2] d;"
+        "int i = 1;"
+        "d[i] = i * 3 + 5000000000;"
+        "b[c][i - 1] = -(d[1] - b[a][1] * (c + i));"
+    ;
+
+    CompileOptions folded;
+    folded.foldConstants = true;
+
+    CompileOptions optimized;
+    optimized.eliminateCommonSubexpressions = true;
+    optimized.propagateCopies = true;
+    optimized.registers = 2;
+
+    for (const auto& options : { CompileOptions{}, folded, optimized })
+    {
+        const ThreeAddressCode code = Compiler{}.CompileToIr(std::string{ input }, options);
+        const ExecutionResult expected = Execute(code);
+
+        std::ofstream(dir / "program.s") << GenerateAssembly(code);
+        const std::string build = "cc -o '" + (dir / "program").string() + "' '" + (dir / "main.c").string()
+            + "' '" + (dir / "program.s").string() + "'";
+        BOOST_TEST_REQUIRE(std::system(build.c_str()) == 0);
+
+        const std::string run = "'" + (dir / "program").string() + "' " + std::to_string(expected.memory.size())
+            + " '" + (dir / "memory.bin").string() + "'";
+        BOOST_TEST_REQUIRE(std::system(run.c_str()) == 0);
+
+        std::ifstream image(dir / "memory.bin", std::ios::binary);
+        const std::string bytes{ std::istreambuf_iterator<char>(image), std::istreambuf_iterator<char>() };
+        BOOST_TEST_REQUIRE(bytes.size() == expected.memory.size());
+        BOOST_TEST(std::memcmp(bytes.data(), expected.memory.data(), bytes.size()) == 0);
+    }
+
+    std::filesystem::remove_all(dir);
+#endif
+}
+
+BOOST_AUTO_TEST_CASE(CompileBatchTest)
+{
+    std::vector<std::string> inputs;
+    for (size_t i = 0; i < 200; ++i)
+    {
+        if (i % 7 == 3)
+            inputs.push_back("x = undefined;");
+        else
+            inputs.push_back("int[4] a; int x = " + std::to_string(i) + "; a[x / 64] = x * 2;");
+    }
+
+    const Compiler compiler;
+    for (const size_t threads : { 1, 4 })
+    {
+        const auto results = compiler.CompileBatch(inputs, {}, threads);
+        BOOST_TEST_REQUIRE(results.size() == inputs.size());
+
+        for (size_t i = 0; i < inputs.size(); ++i)
+        {
+            if (i % 7 == 3)
+            {
+                BOOST_TEST(!results[i].Succeeded());
+                BOOST_CHECK_THROW(std::rethrow_exception(results[i].error), std::runtime_error);
+            }
+            else
+            {
+                BOOST_TEST(results[i].Succeeded());
+                BOOST_TEST(results[i].code == compiler.Compile(std::string(inputs[i])));
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(ParallelChunksTest)
+{
+    std::string input = "int x = 0; int[4][2] a; int y; w = 3; y = 3;";
+    for (size_t i = 0; i < 300; ++i)
+    {
+        const std::string n = std::to_string(i);
+        input += "int[3] b" + n + "; float f" + n + " = x * " + n + ";";
+        input += "b" + n + "[x / 100] = a[1][x / 200] + y;";
+        if (i % 50 == 0)
+            input += "int y; float w; int x;";
+        input += "x = x + " + std::to_string(i % 7) + ";";
+    }
+
+    const Compiler compiler;
+    const std::string expectedCode = compiler.Compile(std::string(input));
+
+    for (const size_t chunks : { 2, 3, 7, 64, 10000 })
+    {
+        CompileOptions options;
+        options.parallelChunks = chunks;
+        BOOST_TEST(compiler.Compile(std::string(input), options) == expectedCode);
+    }
+
+    // Each chunk carries the declarations of the names it uses, not the whole
+    // table.
+    for (ProgramChunk& chunk : SplitProgram(Tokenize(std::string(input)), 64))
+    {
+        std::set<std::string> names;
+        for (; !chunk.tokens.empty(); chunk.tokens.pop())
+        {
+            if (chunk.tokens.front().first == "id")
+                names.insert(chunk.tokens.front().second);
+        }
+        BOOST_TEST(chunk.symbols.Size() <= names.size());
+    }
+
+    CompileOptions options;
+    options.parallelChunks = 4;
+    const std::string invalid = "int x = 0; x = 1; x = 2; x = z; int z; z = 1; x = 3; x = 4; x = 5;";
+    try
+    {
+        compiler.Compile(std::string(invalid), options);
+        BOOST_ERROR("Compile must throw");
+    }
+    catch (const std::runtime_error& e)
+    {
+        BOOST_TEST(e.what() == std::string("Undefined symbol 'z'"));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(IncrementalCompilerTest)
+{
+    std::string program = "int x = 0; int[4][2] a;";
+    for (size_t i = 0; i < 100; ++i)
+        program += "int y" + std::to_string(i) + " = x; a[x / 100][1] = x * " + std::to_string(i) + "; x = x + a[1][0];";
+
+    const Compiler compiler;
+    IncrementalCompiler incremental{ compiler };
+
+    BOOST_TEST(incremental.Compile(program) == compiler.Compile(std::string(program)));
+    BOOST_TEST(incremental.LastCompile().compiledUnits == 200u);
+
+    const auto edit = [&](size_t pos, size_t count, const std::string& text)
+    {
+        program.replace(pos, count, text);
+        BOOST_TEST(incremental.Compile(program) == compiler.Compile(std::string(program)));
+        return incremental.LastCompile();
+    };
+
+    // A changed constant in one assignment.
+    auto stats = edit(program.find("x * 57"), 6, "x * 58 + 1");
+    BOOST_TEST(stats.compiledUnits == 1u);
+    BOOST_TEST(stats.reusedUnits == 199u);
+
+    // A new statement, and the same statement removed again.
+    stats = edit(program.find("int y80"), 0, "x = 7;");
+    BOOST_TEST(stats.compiledUnits == 1u);
+    stats = edit(program.find("x = 7;"), 6, "");
+    BOOST_TEST(stats.compiledUnits <= 2u);
+
+    // Changing the declaration of a redeclares it for everything after it.
+    stats = edit(program.find("[4][2] a"), 6, "[8][3]");
+    BOOST_TEST(stats.compiledUnits == 200u);
+
+    // A new declaration of a name only affects the units that use it.
+    stats = edit(program.find("int y40"), 0, "int y90; ");
+    BOOST_TEST(stats.compiledUnits == 2u);
+
+    // Errors are the ones of the whole-program compile, and compiling
+    // carries on after them.
+    const std::string valid = program;
+    program.replace(program.find("x * 12"), 1, "z");
+    BOOST_CHECK_THROW(incremental.Compile(program), std::runtime_error);
+    program = valid;
+    BOOST_TEST(incremental.Compile(program) == compiler.Compile(std::string(program)));
+}
+
+BOOST_AUTO_TEST_CASE(CompileStreamTest)
+{
+    std::string input = "int[4][3] a; float f = 1;";
+    for (size_t i = 0; i < 500; ++i)
+    {
+        const std::string n = std::to_string(i);
+        input += "int x" + n + " = " + n + " * f; int y" + n + ";";
+        input += "a[x" + n + " / 500][2] = a[1][x" + n + " / 250] + 1234567 - y" + n + ";";
+    }
+
+    const Compiler compiler;
+    const std::string expectedCode = compiler.Compile(std::string(input));
+
+    for (const size_t chunkSize : { 1, 7, 4096 })
+    {
+        std::istringstream in(input);
+        std::ostringstream out;
+        compiler.CompileStream(in, out, {}, chunkSize);
+        BOOST_TEST(out.str() == expectedCode);
+    }
+
+    std::istringstream in("int x = 1; y = x + 2; y = z;");
+    std::ostringstream out;
+    BOOST_CHECK_THROW(compiler.CompileStream(in, out), std::runtime_error);
+    BOOST_TEST(out.str() == "x = 1\nt0 = x + 2\ny = t0\n");
+}
+
+BOOST_AUTO_TEST_CASE(PipelineLexerTest)
+{
+    std::string input = "int[4][3] a; float f = 1;";
+    for (size_t i = 0; i < 500; ++i)
+    {
+        const std::string n = std::to_string(i);
+        input += "int x" + n + " = " + n + " * f;";
+        input += "a[x" + n + " / 500][2] = a[1][x" + n + " / 250] + 1234567 - x" + n + ";";
+    }
+
+    const Compiler compiler;
+    CompileOptions pipelined;
+    pipelined.pipelineLexer = true;
+
+    BOOST_TEST(compiler.Compile(std::string(input), pipelined) == compiler.Compile(std::string(input)));
+
+    const auto error = [&compiler](std::string text, const CompileOptions& options)
+    {
+        try
+        {
+            compiler.Compile(std::move(text), options);
+        }
+        catch (const std::runtime_error& e)
+        {
+            return std::string(e.what());
+        }
+        return std::string();
+    };
+
+    // A syntax error ahead of a lexical one still reports the lexical error.
+    for (const std::string& text : { input + "x = 1 # 2;", "x = = 1;" + input + "x = 1 # 2;", input + "x = = 1;", std::string("x = 1") })
+    {
+        const std::string expected = error(text, {});
+        BOOST_TEST(!expected.empty());
+        BOOST_TEST(error(text, pipelined) == expected);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(SymbolTableTest)
+{
+    SymbolTable symbols;
+    BOOST_TEST(symbols.Find("a") == SymbolTable::NoName);
+
+    std::vector<NameId> ids;
+    for (size_t i = 0; i < 1000; ++i)
+        ids.push_back(symbols.Intern("x" + std::to_string(i)));
+
+    for (size_t i = 0; i < ids.size(); ++i)
+    {
+        BOOST_TEST(ids[i] == i);
+        BOOST_TEST(symbols.Find("x" + std::to_string(i)) == ids[i]);
+        BOOST_TEST(symbols.Name(ids[i]) == "x" + std::to_string(i));
+        BOOST_TEST(!symbols.TypeOf(ids[i]));
+    }
+    BOOST_TEST(symbols.Intern("x7") == ids[7]);
+    BOOST_TEST(symbols.Size() == 1000u);
+
+    DeclareSymbol(symbols, "int", "a", { "4", "3" });
+    const TypeDescriptor* a = symbols.Lookup("a");
+    BOOST_REQUIRE(a);
+    BOOST_TEST(a->Rank() == 2u);
+    BOOST_TEST(TypeName(a->levels[0]) == "int[][]");
+    BOOST_TEST(a->levels[0].size == 96u);
+    BOOST_TEST(a->Stride(0) == 24u);
+    BOOST_TEST(a->Stride(1) == 8u);
+    BOOST_TEST(TypeName(a->levels[2]) == "int");
+
+    // The first declaration wins; a later one only adds missing dimensions.
+    DeclareSymbol(symbols, "float", "a", { "5" });
+    BOOST_TEST(symbols.Lookup("a")->Rank() == 2u);
+    BOOST_TEST(TypeName(symbols.Lookup("a")->levels[1]) == "int[]");
+
+    DeclareSymbol(symbols, "int", "b", {});
+    DeclareSymbol(symbols, "float", "b", { "5", "2" });
+    const TypeDescriptor* b = symbols.Lookup("b");
+    BOOST_REQUIRE(b->levels.size() == 3u);
+    BOOST_TEST(TypeName(b->levels[0]) == "int");
+    BOOST_TEST(TypeName(b->levels[1]) == "float[]");
+    BOOST_TEST(TypeName(b->levels[2]) == "float");
+    BOOST_TEST(b->Stride(0) == 8u);
+    BOOST_TEST(b->Stride(1) == 4u);
+
+    const Compiler compiler;
+    BOOST_TEST(compiler.Compile("int a; float[3][2] a; a[1][1] = 2;") == "t0 = 1 * 8\nt1 = 1 * 4\nt2 = t0 + t1\nt3 = a + t2\n*t3 = 2\n");
+    BOOST_CHECK_THROW(compiler.Compile("int[2] a; a[1][1] = 2;"), std::runtime_error);
+
+    // Every access to an array type shares the constant operands of its strides.
+    const ThreeAddressCode code = compiler.CompileToIr("int[4][3] m; int i; m[i][i] = m[i][2] + m[1][i];");
+    BOOST_TEST(code.constants.size() == 4u);
+    BOOST_TEST((code.temps.back().type == ScalarType::Int));
+    BOOST_TEST((code.temps.front().type == ScalarType::Size));
+}
+
+BOOST_AUTO_TEST_CASE(StorageLayoutTest)
+{
+    const std::string input =
+        "float[3] f;"
+        "int[4] a;"
+        "float g;"
+        "int i;"
+        "int j;"
+        "j = 1;"
+        "a[j] = j + j * g;"
+        "f[j] = i;"
+    ;
+
+    CompileOptions options;
+    options.allocateStorage = true;
+
+    CompileReport report;
+    const ThreeAddressCode code = Compiler{}.CompileToIr(std::string{ input }, options, &report);
+
+    // Scalars by alignment and use, then arrays from the smallest up; the
+    // only padding is before the first array.
+    const std::string expectedLayout =
+        "j: data+0, 8 bytes\n"
+        "i: data+8, 8 bytes\n"
+        "g: data+16, 4 bytes\n"
+        "a: data+24, 32 bytes\n"
+        "f: data+56, 12 bytes\n"
+        "t0: frame+0, 8 bytes\n"
+        "t1: frame+8, 8 bytes\n"
+        "t2: frame+16, 8 bytes\n"
+        "t3: frame+24, 8 bytes\n"
+        "t4: frame+32, 8 bytes\n"
+        "t5: frame+40, 8 bytes\n"
+        "footprint: 116 bytes\n";
+
+    BOOST_TEST(PrintStorageLayout(code, report.storage).c_str() == expectedLayout.c_str());
+    BOOST_TEST(report.storage.data.size == LayOutVariables(code).size);
+
+    const ExecutionResult result = Execute(code);
+    BOOST_TEST(result.Value("j") == 1);
+    BOOST_TEST(result.Value("a", 8) == 1);
+    BOOST_TEST(result.memory.size() == 68u);
+}
+
+BOOST_AUTO_TEST_CASE(CompileStatisticsTest)
+{
+    const Compiler compiler;
+    CompileOptions options;
+    options.collectStatistics = true;
+
+    CompileReport report;
+    const std::string code = compiler.Compile("int[2] a; int b = 1; a[b] = b + 2;", options, &report);
+    const CompileStatistics& statistics = report.statistics;
+
+    BOOST_TEST(statistics.tokens == 20u);
+    BOOST_TEST(statistics.shifts == statistics.tokens);
+    // Reached by the GOTO after the empty Declarations that ends the list,
+    // on top of G Declaration ; Declaration = Expr ; and the start state.
+    BOOST_TEST(statistics.stackHighWater == 9u);
+    BOOST_TEST(statistics.temps == 3u);
+    BOOST_TEST(statistics.quads == 5u);
+    BOOST_TEST(statistics.codeBytes == code.size());
+
+    const auto reductions = [&statistics](const std::string& production)
+    {
+        const auto it = std::find_if(statistics.reductions.begin(), statistics.reductions.end(),
+            [&production](const auto& entry) { return entry.first == production; });
+        return it == statistics.reductions.end() ? ~size_t{ 0 } : it->second;
+    };
+    BOOST_TEST(reductions("Expr -> id") == 2u);
+    BOOST_TEST(reductions("Expr -> num") == 2u);
+    BOOST_TEST(reductions("Expr -> Expr + Expr") == 1u);
+    BOOST_TEST(reductions("Declaration -> BasicType IndexesOptional id") == 2u);
+    BOOST_TEST(reductions("Expr -> Expr * Expr") == 0u);
+
+    CompileReport plain;
+    BOOST_TEST(compiler.Compile("int[2] a; int b = 1; a[b] = b + 2;", {}, &plain) == code);
+    BOOST_TEST(plain.statistics.tokens == 0u);
+    BOOST_TEST(plain.statistics.reductions.empty());
+}
+
+BOOST_AUTO_TEST_CASE(CompileArenaTest)
+{
+    const Compiler compiler;
+    CompileOptions arena;
+    arena.useArena = true;
+
+    const auto program = [](size_t statements)
+    {
+        std::string input = "int[4][3] a; int b = 1;";
+        for (size_t i = 0; i < statements; ++i)
+            input += "a[b][2] = a[1][b] + " + std::to_string(i) + " * b;";
+        return input;
+    };
+
+    CompileReport small;
+    CompileReport large;
+    BOOST_TEST(compiler.Compile(program(100), arena, &small) == compiler.Compile(program(100)));
+    BOOST_TEST(compiler.Compile(program(10000), arena, &large) == compiler.Compile(program(10000)));
+
+    BOOST_TEST(small.arena.tokenize.count > 0u);
+    BOOST_TEST(small.arena.parse.count > 0u);
+
+    // The parser allocates in proportion to the program, but only from the
+    // arena; the arena itself takes a few growing blocks from the heap.
+    BOOST_TEST(large.arena.parse.count > 50 * small.arena.parse.count);
+    BOOST_TEST(large.arena.heap.count < small.arena.heap.count + 16);
+    BOOST_TEST(large.arena.heap.bytes >= large.arena.tokenize.bytes + large.arena.parse.bytes);
+
+    // Nothing else on the way allocates per statement either: all the heap
+    // traffic of the compile is the arena blocks and the geometric growth of
+    // the code tables.
+    const auto heapOf = [&compiler](std::string input, const CompileOptions& options)
+    {
+        return HeapAllocationsOf([&] { compiler.CompileToIr(std::move(input), options); });
+    };
+    const size_t smallHeap = heapOf(program(100), arena);
+    const size_t largeHeap = heapOf(program(10000), arena);
+    BOOST_TEST(largeHeap < smallHeap + 64);
+    BOOST_TEST(largeHeap < 200u);
+    BOOST_TEST(heapOf(program(10000), {}) > 10000u);
+
+    CompileReport plain;
+    compiler.Compile(program(100), {}, &plain);
+    BOOST_TEST(plain.arena.parse.count == 0u);
+
+    BOOST_CHECK_THROW(compiler.Compile("int a; x = y;", arena), std::runtime_error);
+}
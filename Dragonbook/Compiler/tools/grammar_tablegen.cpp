@@ -0,0 +1,167 @@
+// Turns a grammar CSV into a header with constexpr parse tables for
+// StaticLalrTable.
+//
+// Usage: grammar_tablegen <grammar.csv> <output.h> <struct name>
+
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <algorithm>
+
+#include "../src/grammar_reader.h"
+
+namespace
+{
+    std::string Quote(std::string_view str)
+    {
+        std::string quoted = "\"";
+        for (const char c : str)
+        {
+            if (c == '"' || c == '\\')
+                quoted += '\\';
+            quoted += c;
+        }
+        return quoted + "\"";
+    }
+
+    const char* ActionTypeName(Action::Type type)
+    {
+        switch (type)
+        {
+        case Action::Type::Shift:
+            return "Shift";
+        case Action::Type::Reduce:
+            return "Reduce";
+        case Action::Type::Accept:
+            return "Accept";
+        case Action::Type::Error:
+            break;
+        }
+        return "Error";
+    }
+
+    template<typename T, typename Printer>
+    void WriteArray(std::ostream& out, const char* type, const char* name, const std::vector<T>& values, Printer print)
+    {
+        out << "    static constexpr std::array<" << type << ", " << values.size() << "> " << name << "{ {\n";
+        for (size_t i = 0; i < values.size(); ++i)
+        {
+            out << ((i % 8 == 0) ? "        " : " ");
+            print(out, values[i]);
+            out << ((i + 1 == values.size()) ? "\n" : (i % 8 == 7) ? ",\n" : ",");
+        }
+        out << "    } };\n";
+    }
+
+    std::string GenerateHeader(const LalrTable& table, const std::string& structName)
+    {
+        const auto symbols = static_cast<SymbolId>(table.SymbolsCount());
+
+        std::vector<std::string_view> names;
+        std::vector<bool> nonTerminals;
+        std::vector<SymbolId> terminalIndex;
+        for (SymbolId i = 0; i < symbols; ++i)
+        {
+            names.push_back(table.SymbolName(i));
+            nonTerminals.push_back(table.IsNonTerminal(i));
+            if (!table.IsNonTerminal(i))
+                terminalIndex.push_back(i);
+        }
+        std::sort(terminalIndex.begin(), terminalIndex.end(),
+            [&table](SymbolId lhs, SymbolId rhs) {
+                return table.SymbolName(lhs) < table.SymbolName(rhs);
+            }
+        );
+
+        std::vector<SymbolId> lhs;
+        std::vector<uint16_t> lengths;
+        std::vector<uint32_t> rhsIndex;
+        std::vector<SymbolId> rhs;
+        for (size_t p = 0; p < table.ProductionsCount(); ++p)
+        {
+            const auto to = table.ProductionRhs(p);
+            lhs.push_back(table.ProductionLhs(p));
+            lengths.push_back(static_cast<uint16_t>(to.size()));
+            rhsIndex.push_back(static_cast<uint32_t>(rhs.size()));
+            rhs.insert(rhs.end(), to.begin(), to.end());
+        }
+
+        std::vector<Action> actions;
+        for (State s = 0; s < table.StatesCount(); ++s)
+            for (SymbolId i = 0; i < symbols; ++i)
+                actions.push_back(table.At(s, i));
+
+        const auto printNumber = [](std::ostream& out, auto value) { out << +value; };
+
+        std::ostringstream out;
+        out << "// Generated by grammar_tablegen. Do not edit.\n"
+            << "#pragma once\n\n"
+            << "#include <array>\n"
+            << "#include <cstdint>\n"
+            << "#include <string_view>\n\n"
+            << "#include \"static_table.h\"\n\n"
+            << "struct " << structName << "Data\n"
+            << "{\n"
+            << "    static constexpr uint64_t sourceHash = " << table.SourceHash() << "ull;\n"
+            << "    static constexpr size_t statesCount = " << table.StatesCount() << ";\n"
+            << "    static constexpr size_t symbolsCount = " << table.SymbolsCount() << ";\n\n";
+
+        WriteArray(out, "std::string_view", "symbolNames", names,
+            [](std::ostream& out, std::string_view name) { out << Quote(name); });
+        WriteArray(out, "bool", "nonTerminals", nonTerminals,
+            [](std::ostream& out, bool nonTerminal) { out << (nonTerminal ? "true" : "false"); });
+        WriteArray(out, "SymbolId", "terminalIndex", terminalIndex, printNumber);
+        WriteArray(out, "SymbolId", "productionLhs", lhs, printNumber);
+        WriteArray(out, "uint16_t", "productionLength", lengths, printNumber);
+        WriteArray(out, "uint32_t", "productionRhsIndex", rhsIndex, printNumber);
+        WriteArray(out, "SymbolId", "productionRhs", rhs, printNumber);
+        WriteArray(out, "Action", "actions", actions,
+            [](std::ostream& out, const Action& action) {
+                out << "{ Action::Type::" << ActionTypeName(action.type) << ", " << action.value << " }";
+            });
+
+        out << "};\n\n"
+            << "using " << structName << " = StaticLalrTable<" << structName << "Data>;\n";
+
+        return out.str();
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc != 4)
+    {
+        std::cerr << "Usage: grammar_tablegen <grammar.csv> <output.h> <struct name>" << std::endl;
+        return 1;
+    }
+
+    try
+    {
+        const std::string header = GenerateHeader(ParseGrammarFile(argv[1]), argv[3]);
+
+        // Leave the header untouched when nothing changed, so that dependent
+        // sources are not rebuilt.
+        std::ifstream existing(argv[2], std::ios::binary);
+        std::ostringstream current;
+        current << existing.rdbuf();
+        if (existing && current.str() == header)
+            return 0;
+        existing.close();
+
+        std::ofstream out(argv[2], std::ios::binary | std::ios::trunc);
+        out << header;
+        if (!out)
+        {
+            std::cerr << "Cannot write '" << argv[2] << "'" << std::endl;
+            return 1;
+        }
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}